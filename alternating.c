@@ -372,29 +372,33 @@ void print_alternating() /* dumps the alternating automaton */
   int i;
   ATrans *t;
 
-  fprintf(tl_out, "init :\n");
+  out_puts("init :\n");
   for(t = transition[0]; t; t = t->nxt) {
     print_set(t->to, 0);
-    fprintf(tl_out, "\n");
+    out_putc('\n');
   }
   
   for(i = node_id - 1; i > 0; i--) {
     if(!label[i])
       continue;
-    fprintf(tl_out, "state %i : ", i);
+    out_puts("state ");
+    out_putint(i);
+    out_puts(" : ");
+    out_flush(); /* dump prints on tl_out */
     dump(label[i]);
-    fprintf(tl_out, "\n");
+    out_putc('\n');
     for(t = transition[i]; t; t = t->nxt) {
       if (empty_set(t->pos, 1) && empty_set(t->neg, 1))
-	fprintf(tl_out, "1");
+	out_putc('1');
       print_set(t->pos, 1);
-      if (!empty_set(t->pos,1) && !empty_set(t->neg,1)) fprintf(tl_out, " & ");
+      if (!empty_set(t->pos,1) && !empty_set(t->neg,1)) out_puts(" & ");
       print_set(t->neg, 2);
-      fprintf(tl_out, " -> ");
+      out_puts(" -> ");
       print_set(t->to, 0);
-      fprintf(tl_out, "\n");
+      out_putc('\n');
     }
   }
+  out_flush();
 }
 
 /********************************************************************\
@@ -441,3 +445,19 @@ void mk_alternating(Node *p) /* generates an alternating automaton for p */
   releasenode(1, p);
   tfree(label);
 }
+
+void free_alternating() /* frees the alternating automaton, so that another
+                           formula can be translated in the same run */
+{
+  int i;
+  for(i = 0; i < node_id; i++)
+    free_atrans(transition[i], 1);
+  free_all_atrans(); /* the sets of the pool have the sizes of this formula */
+  tfree(transition);
+  tfree(final_set);
+  if(sym_table) tfree(sym_table);
+  sym_table = (char **)0;
+  node_id = 1;
+  sym_id = 0;
+  astate_count = atrans_count = 0;
+}
@@ -0,0 +1,240 @@
+
+/* This file contains the function required to print a Büchi
+   automaton as a C monitor stepping many traces at once (option
+   -t cbatch). The traces are the lanes of the monitor, stored in
+   structure of arrays form : word w of the current states of lane l is
+   _ltl2ba_current[w][l], and word w of its valuation is
+   _ltl2ba_valuation[w][l]. A step is the same straight-line code for
+   every lane, without branches, so that the compiler can vectorize the
+   loop on the lanes. Each transition is a few AND on the words of the
+   lane, from the pos/neg guards of the BTrans.
+   The code compiled with -D_LTL2BA_BENCH is a benchmark measuring the
+   number of traces checked per second.
+*/
+
+#include "ltl2ba.h"
+
+extern int accept;
+extern BState *bstates;
+
+extern int sym_id, sym_size, mod;
+extern char** sym_table;
+
+extern void put_uform(void);
+
+/* Print the condition of a transition on the lane of the step */
+void
+print_cbatch_guard(BTrans *t) {
+    int i;
+
+    for (i = 0; i < sym_size; i++) {
+        if (t->pos[i]) {
+            out_puts(" & ((v");
+            out_putint(i);
+            out_puts(" & ");
+            out_putuint(t->pos[i]);
+            out_puts("u) == ");
+            out_putuint(t->pos[i]);
+            out_puts("u)");
+        }
+        if (t->neg[i]) {
+            out_puts(" & ((v");
+            out_putint(i);
+            out_puts(" & ");
+            out_putuint(t->neg[i]);
+            out_puts("u) == 0u)");
+        }
+    }
+}
+
+/* Print the benchmark of the monitor */
+void
+print_cbatch_bench() {
+
+    out_puts("#ifdef _LTL2BA_BENCH\n");
+    out_puts("#include <stdio.h>\n#include <time.h>\n\n");
+    out_puts("#ifndef _LTL2BA_BENCH_TRACES\n#define _LTL2BA_BENCH_TRACES 1000000\n#endif\n");
+    out_puts("#ifndef _LTL2BA_BENCH_LENGTH\n#define _LTL2BA_BENCH_LENGTH 100\n#endif\n\n");
+    out_puts("/* Random valuations, given to every block of traces */\n");
+    out_puts("unsigned int _ltl2ba_bench[_LTL2BA_BENCH_LENGTH][_LTL2BA_SYM_WORDS][_LTL2BA_LANES];\n\n");
+    out_puts("int\nmain() {\n");
+    out_puts("\tunsigned int seed = 2463534242u;\n");
+    out_puts("\tlong n, accepting = 0, rejected = 0;\n");
+    out_puts("\tint i, w, l;\n");
+    out_puts("\tclock_t start;\n");
+    out_puts("\tdouble s;\n\n");
+    out_puts("\tfor (i = 0; i < _LTL2BA_BENCH_LENGTH; i++)\n");
+    out_puts("\t\tfor (w = 0; w < _LTL2BA_SYM_WORDS; w++)\n");
+    out_puts("\t\t\tfor (l = 0; l < _LTL2BA_LANES; l++) {\n");
+    out_puts("\t\t\t\tseed ^= seed << 13;\n");
+    out_puts("\t\t\t\tseed ^= seed >> 17;\n");
+    out_puts("\t\t\t\tseed ^= seed << 5;\n");
+    out_puts("\t\t\t\t_ltl2ba_bench[i][w][l] = seed;\n");
+    out_puts("\t\t\t}\n\n");
+    out_puts("\tstart = clock();\n");
+    out_puts("\tfor (n = 0; n < _LTL2BA_BENCH_TRACES; n += _LTL2BA_LANES) {\n");
+    out_puts("\t\t_ltl2ba_reset();\n");
+    out_puts("\t\tfor (i = 0; i < _LTL2BA_BENCH_LENGTH; i++) {\n");
+    out_puts("\t\t\tfor (w = 0; w < _LTL2BA_SYM_WORDS; w++)\n");
+    out_puts("\t\t\t\tfor (l = 0; l < _LTL2BA_LANES; l++)\n");
+    out_puts("\t\t\t\t\t_ltl2ba_valuation[w][l] = _ltl2ba_bench[i][w][l];\n");
+    out_puts("\t\t\t_ltl2ba_step();\n");
+    out_puts("\t\t}\n");
+    out_puts("\t\tfor (l = 0; l < _LTL2BA_LANES; l++) {\n");
+    out_puts("\t\t\taccepting += _ltl2ba_accepting(l);\n");
+    out_puts("\t\t\trejected += _ltl2ba_rejected(l);\n");
+    out_puts("\t\t}\n");
+    out_puts("\t}\n");
+    out_puts("\ts = (double)(clock() - start) / CLOCKS_PER_SEC;\n");
+    out_puts("\tprintf(\"%ld traces of %d steps in %.3f s : %.0f traces/s\\n\",\n");
+    out_puts("\t       n, _LTL2BA_BENCH_LENGTH, s, s > 0 ? n / s : 0.0);\n");
+    out_puts("\tprintf(\"%ld accepting, %ld rejected\\n\", accepting, rejected);\n");
+    out_puts("\treturn 0;\n");
+    out_puts("}\n");
+    out_puts("#endif\n");
+}
+
+/* Print a buchi automaton as a batched C monitor */
+void
+print_cbatch_buchi() {
+
+    BState *s;
+    BTrans *t;
+    int n_state = 0, state_words;
+    int i, w;
+    unsigned int *init, *acc;
+
+    /* Give an id to every state */
+    for (s = bstates->prv; s != bstates; s = s->prv, n_state++)
+        s->label = n_state;
+    state_words = n_state / 32 + 1;
+
+    /* Initial and accepting states, as bitsets */
+    init = (unsigned int *)tl_emalloc(state_words * sizeof(int));
+    acc = (unsigned int *)tl_emalloc(state_words * sizeof(int));
+    for (s = bstates->prv; s != bstates; s = s->prv) {
+        if (s->id == -1)
+            init[s->label / 32] |= 1u << s->label % 32;
+        /* s->id == 0 means s is an accepting well */
+        if (s->final == accept || s->id == 0)
+            acc[s->label / 32] |= 1u << s->label % 32;
+    }
+
+    out_puts("/* ");
+    put_uform();
+    out_puts(" */\n\n");
+
+    out_puts("/* Atomic propositions : bit i % 32 of the word i / 32 of a valuation\n");
+    for (i = 0; i < sym_id; i++) {
+        out_puts("   ");
+        out_putint(i);
+        out_puts(" : ");
+        out_puts(sym_table[i]);
+        out_putc('\n');
+    }
+    out_puts("*/\n\n");
+
+    out_puts("#ifndef _LTL2BA_LANES\n#define _LTL2BA_LANES 64\n#endif\n");
+    out_puts("#define _LTL2BA_STATES ");
+    out_putint(n_state ? n_state : 1);
+    out_puts("\n#define _LTL2BA_STATE_WORDS ");
+    out_putint(state_words);
+    out_puts("\n#define _LTL2BA_SYM_WORDS ");
+    out_putint(sym_size);
+    out_puts("\n\n");
+
+    out_puts("/* Current states and valuation of each trace (lane) */\n");
+    out_puts("unsigned int _ltl2ba_current[_LTL2BA_STATE_WORDS][_LTL2BA_LANES];\n");
+    out_puts("unsigned int _ltl2ba_valuation[_LTL2BA_SYM_WORDS][_LTL2BA_LANES];\n\n");
+
+    out_puts("void\n_ltl2ba_reset() {\n");
+    out_puts("\tint l;\n");
+    out_puts("\tfor (l = 0; l < _LTL2BA_LANES; l++) {\n");
+    for (w = 0; w < state_words; w++) {
+        out_puts("\t\t_ltl2ba_current[");
+        out_putint(w);
+        out_puts("][l] = ");
+        out_putuint(init[w]);
+        out_puts("u;\n");
+    }
+    out_puts("\t}\n");
+    out_puts("}\n\n");
+
+    /* One step of every lane */
+    out_puts("void\n_ltl2ba_step() {\n");
+    out_puts("\tint l;\n");
+    out_puts("\tfor (l = 0; l < _LTL2BA_LANES; l++) {\n");
+    for (w = 0; w < state_words; w++) {
+        out_puts("\t\tunsigned int c");
+        out_putint(w);
+        out_puts(" = _ltl2ba_current[");
+        out_putint(w);
+        out_puts("][l], n");
+        out_putint(w);
+        out_puts(" = 0;\n");
+    }
+    for (i = 0; i < sym_size; i++) {
+        out_puts("\t\tunsigned int v");
+        out_putint(i);
+        out_puts(" = _ltl2ba_valuation[");
+        out_putint(i);
+        out_puts("][l];\n");
+    }
+    for (s = bstates->prv; s != bstates; s = s->prv)
+        for (t = s->trans->nxt; t != s->trans; t = t->nxt) {
+            out_puts("\t\tn");
+            out_putint(t->to->label / 32);
+            out_puts(" |= (unsigned int)((c");
+            out_putint(s->label / 32);
+            out_puts(" >> ");
+            out_putint(s->label % 32);
+            out_puts(" & 1u)");
+            print_cbatch_guard(t);
+            out_puts(") << ");
+            out_putint(t->to->label % 32);
+            out_puts(";\n");
+        }
+    for (w = 0; w < state_words; w++) {
+        out_puts("\t\t_ltl2ba_current[");
+        out_putint(w);
+        out_puts("][l] = n");
+        out_putint(w);
+        out_puts(";\n");
+    }
+    out_puts("\t}\n");
+    out_puts("}\n\n");
+
+    /* Verdicts */
+    out_puts("/* No run of the automaton reads the trace of the lane l */\n");
+    out_puts("int\n_ltl2ba_rejected(int l) {\n");
+    out_puts("\treturn !(");
+    for (w = 0; w < state_words; w++) {
+        if (w)
+            out_puts(" | ");
+        out_puts("_ltl2ba_current[");
+        out_putint(w);
+        out_puts("][l]");
+    }
+    out_puts(");\n");
+    out_puts("}\n\n");
+    out_puts("/* A run of the automaton on the trace of the lane l is in an accepting state */\n");
+    out_puts("int\n_ltl2ba_accepting(int l) {\n");
+    out_puts("\treturn (");
+    for (w = 0; w < state_words; w++) {
+        if (w)
+            out_puts(" | ");
+        out_puts("(_ltl2ba_current[");
+        out_putint(w);
+        out_puts("][l] & ");
+        out_putuint(acc[w]);
+        out_puts("u)");
+    }
+    out_puts(") != 0;\n");
+    out_puts("}\n\n");
+
+    print_cbatch_bench();
+    out_flush();
+
+    tfree(init);
+    tfree(acc);
+}
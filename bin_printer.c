@@ -0,0 +1,171 @@
+
+/* This file contains the functions required to print an automaton
+  in the binary format described in ltl2ba_bin.h (option -t bin).
+  The whole file is built in memory, then written at once.
+  The Büchi automaton has its acceptance on the states, and the
+  generalized Büchi automaton (option -g) on the transitions.
+*/
+
+#include "ltl2ba.h"
+#include "ltl2ba_bin.h"
+
+extern int accept;
+extern BState *bstates;
+extern GState *gstates, **init;
+extern int init_size, *final;
+
+extern int sym_id, sym_size;
+extern char** sym_table;
+
+/* The file being built, and its header */
+static unsigned int *bin;
+static BinHeader *bh;
+
+/* Allocate the file and compute the offsets of its arrays */
+void
+bin_alloc(int nb_states, int nb_trans, int nb_init, int nb_acc, int flags) {
+
+  int i, names = 0, size;
+
+  for (i = 0; i < sym_id; i++)
+    names += strlen(sym_table[i]) + 1;
+
+  size = sizeof(BinHeader) / 4;
+  size += nb_init;
+  size += 2 * nb_states + 1;
+  size += nb_trans * (1 + 2 * sym_size);
+  if (flags & BIN_GENERALIZED)
+    size += nb_trans * ((nb_acc + 31) / 32);
+  size += sym_id + 1;
+  size += (names + 3) / 4;
+
+  bin = (unsigned int *)tl_emalloc(size * 4); /* filled with 0 */
+  bh = (BinHeader *)bin;
+  bh->magic = BIN_MAGIC;
+  bh->version = BIN_VERSION;
+  bh->flags = flags;
+  bh->size = size * 4;
+  bh->nb_states = nb_states;
+  bh->nb_trans = nb_trans;
+  bh->nb_init = nb_init;
+  bh->nb_sym = sym_id;
+  bh->nb_acc = nb_acc;
+  bh->sym_words = sym_size;
+  bh->acc_words = (flags & BIN_GENERALIZED) ? (nb_acc + 31) / 32 : 0;
+
+  bh->init = sizeof(BinHeader);
+  bh->first = bh->init + 4 * nb_init;
+  bh->accepting = bh->first + 4 * (nb_states + 1);
+  bh->dest = bh->accepting + 4 * nb_states;
+  bh->pos = bh->dest + 4 * nb_trans;
+  bh->neg = bh->pos + 4 * nb_trans * sym_size;
+  bh->acc = bh->neg + 4 * nb_trans * sym_size;
+  bh->name = bh->acc + 4 * nb_trans * bh->acc_words;
+  bh->names = bh->name + 4 * (sym_id + 1);
+
+  /* Symbol names */
+  names = 0;
+  for (i = 0; i < sym_id; i++) {
+    bin[bh->name / 4 + i] = names;
+    strcpy((char *)bin + bh->names + names, sym_table[i]);
+    names += strlen(sym_table[i]) + 1;
+  }
+  bin[bh->name / 4 + sym_id] = names;
+}
+
+/* Store the guard of the n-th transition */
+void
+bin_guard(int n, int *pos, int *neg) {
+  int i;
+  for (i = 0; i < sym_size; i++) {
+    bin[bh->pos / 4 + n * sym_size + i] = pos[i];
+    bin[bh->neg / 4 + n * sym_size + i] = neg[i];
+  }
+}
+
+/* Write the file on `tl_out` and free it */
+void
+bin_output() {
+  out_write((char *)bin, bh->size);
+  out_flush();
+  tfree(bin);
+}
+
+/* Print a buchi automaton in binary format */
+void
+print_bin_buchi() {
+
+  BState *s;
+  BTrans *t;
+  int nb_states = 0, nb_trans = 0, n = 0;
+
+  /* Give an id to every state and count the states and transitions */
+  for (s = bstates->prv; s != bstates; s = s->prv, nb_states++) {
+    s->label = nb_states;
+    for (t = s->trans->nxt; t != s->trans; t = t->nxt)
+      nb_trans++;
+  }
+
+  bin_alloc(nb_states, nb_trans, nb_states ? 1 : 0, 1, 0);
+  for (s = bstates->prv; s != bstates; s = s->prv) {
+    if (s->id == -1)
+      bin[bh->init / 4] = s->label;
+    /* s->id == 0 means s is an accepting well */
+    bin[bh->accepting / 4 + s->label] = (s->final == accept || s->id == 0);
+    bin[bh->first / 4 + s->label] = n;
+    for (t = s->trans->nxt; t != s->trans; t = t->nxt, n++) {
+      bin[bh->dest / 4 + n] = t->to->label;
+      bin_guard(n, t->pos, t->neg);
+    }
+  }
+  bin[bh->first / 4 + nb_states] = n;
+  bin_output();
+}
+
+/* Print a generalized buchi automaton in binary format */
+void
+print_bin_generalized() {
+
+  GState *s;
+  GTrans *t;
+  int nb_states = 0, nb_trans = 0, nb_init = 0, n = 0;
+  int i, j;
+
+  /* Give an id to every state and count the states and transitions */
+  for (s = gstates->prv; s != gstates; s = s->prv, nb_states++) {
+    s->label = nb_states;
+    for (t = s->trans->nxt; t != s->trans; t = t->nxt)
+      nb_trans++;
+  }
+  for (i = 0; i < init_size; i++) {
+    if (!init[i])
+      continue;
+    for (j = 0; j < i && init[j] != init[i]; j++)
+      ;
+    if (j == i) /* not counted yet */
+      nb_init++;
+  }
+
+  bin_alloc(nb_states, nb_trans, nb_init, final[0] - 1, BIN_GENERALIZED);
+  for (i = 0, nb_init = 0; i < init_size; i++) {
+    if (!init[i])
+      continue;
+    for (j = 0; j < i && init[j] != init[i]; j++)
+      ;
+    if (j == i)
+      bin[bh->init / 4 + nb_init++] = init[i]->label;
+  }
+  for (s = gstates->prv; s != gstates; s = s->prv) {
+    bin[bh->first / 4 + s->label] = n;
+    for (t = s->trans->nxt; t != s->trans; t = t->nxt, n++) {
+      bin[bh->dest / 4 + n] = t->to->label;
+      bin_guard(n, t->pos, t->neg);
+      for (i = 1; i < final[0]; i++)
+        if (in_set(t->final, final[i]))
+          bin[bh->acc / 4 + n * bh->acc_words + (i - 1) / 32] |=
+            1u << ((i - 1) % 32);
+    }
+  }
+  bin[bh->first / 4 + nb_states] = n;
+  bin_output();
+}
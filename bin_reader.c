@@ -0,0 +1,115 @@
+/***** ltl2ba : bin_reader.c *****/
+
+/* This file contains the reader of the binary format of the automata
+   (see ltl2ba_bin.h). The arrays are not copied: bin_load checks the
+   data given to it and points into it, and bin_map does the same with
+   a file mapped in memory. Both return 0 if the data is not a valid
+   automaton. The result is freed by bin_free.
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "ltl2ba_bin.h"
+
+static int bin_section(BinHeader *h, unsigned int off, unsigned long words)
+{ /* is the array at 'off' inside the file ? */
+  return off % 4 == 0 && off >= sizeof(BinHeader) && off <= h->size &&
+    words <= (h->size - off) / 4;
+}
+
+static int bin_check(BinAut *a)
+{ /* checks the indices, so that the arrays can be used without tests */
+  BinHeader *h = a->header;
+  unsigned int i;
+
+  for(i = 0; i < h->nb_init; i++)
+    if(a->init[i] >= h->nb_states) return 0;
+  if(a->first[0] != 0 || a->first[h->nb_states] != h->nb_trans) return 0;
+  for(i = 0; i < h->nb_states; i++)
+    if(a->first[i] > a->first[i + 1]) return 0;
+  for(i = 0; i < h->nb_trans; i++)
+    if(a->dest[i] >= h->nb_states) return 0;
+  for(i = 0; i <= h->nb_sym; i++) /* null terminated names */
+    if(a->name[i] > h->size - h->names ||
+       (i && (a->name[i] <= a->name[i - 1] || a->names[a->name[i] - 1])))
+      return 0;
+  return 1;
+}
+
+BinAut *bin_load(void *data, unsigned long size)
+{
+  BinHeader *h = (BinHeader *)data;
+  BinAut *a;
+  unsigned long n;
+
+  if(size < sizeof(BinHeader) || (unsigned long)data % 4 ||
+     h->magic != BIN_MAGIC || h->version != BIN_VERSION || h->size > size)
+    return (BinAut *)0;
+  n = h->nb_trans;
+  if(!bin_section(h, h->init, h->nb_init) ||
+     !bin_section(h, h->first, (unsigned long)h->nb_states + 1) ||
+     !bin_section(h, h->accepting, h->nb_states) ||
+     !bin_section(h, h->dest, n) ||
+     !bin_section(h, h->pos, n * h->sym_words) ||
+     !bin_section(h, h->neg, n * h->sym_words) ||
+     !bin_section(h, h->acc, n * h->acc_words) ||
+     !bin_section(h, h->name, (unsigned long)h->nb_sym + 1) ||
+     !bin_section(h, h->names, 0) ||
+     h->sym_words < (h->nb_sym + 31) / 32 ||
+     h->acc_words < ((h->flags & BIN_GENERALIZED) ? (h->nb_acc + 31) / 32 : 0))
+    return (BinAut *)0;
+
+  a = (BinAut *)malloc(sizeof(BinAut));
+  if(!a) return a;
+  a->header    = h;
+  a->init      = (unsigned int *)((char *)data + h->init);
+  a->first     = (unsigned int *)((char *)data + h->first);
+  a->accepting = (unsigned int *)((char *)data + h->accepting);
+  a->dest      = (unsigned int *)((char *)data + h->dest);
+  a->pos       = (unsigned int *)((char *)data + h->pos);
+  a->neg       = (unsigned int *)((char *)data + h->neg);
+  a->acc       = (unsigned int *)((char *)data + h->acc);
+  a->name      = (unsigned int *)((char *)data + h->name);
+  a->names     = (char *)data + h->names;
+  a->map       = (void *)0;
+  a->map_size  = 0;
+
+  if(bin_check(a)) return a;
+  free(a);
+  return (BinAut *)0;
+}
+
+BinAut *bin_map(char *file)
+{
+  struct stat st;
+  BinAut *a = (BinAut *)0;
+  void *map;
+  int fd = open(file, O_RDONLY);
+
+  if(fd < 0) return a;
+  if(fstat(fd, &st) == 0 && st.st_size > 0) {
+    map = mmap((void *)0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(map != MAP_FAILED) {
+      a = bin_load(map, st.st_size);
+      if(a) {
+        a->map = map;
+        a->map_size = st.st_size;
+      }
+      else munmap(map, st.st_size);
+    }
+  }
+  close(fd);
+  return a;
+}
+
+void bin_free(BinAut *a)
+{
+  if(a->map) munmap(a->map, a->map_size);
+  free(a);
+}
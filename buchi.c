@@ -31,6 +31,10 @@
 
 void print_c_buchi();
 void print_json_buchi();
+void print_hoa_buchi();
+void print_bin_buchi();
+void print_cmon_buchi();
+void print_cbatch_buchi();
 
 /********************************************************************\
 |*              Structures and shared variables                     *|
@@ -39,16 +43,18 @@ void print_json_buchi();
 extern GState **init, *gstates;
 extern struct rusage tr_debut, tr_fin;
 extern struct timeval t_diff;
-extern int tl_verbose, tl_stats, tl_simp_diff, tl_simp_fly, tl_simp_scc, tl_type,
-  init_size, *final;
+extern int tl_verbose, tl_stats, tl_simp_diff, tl_simp_fly, tl_simp_scc, tl_simp_sim, tl_type,
+  tl_jobs, tl_trace_count, init_size, *final;
 extern void put_uform(void);
 
 extern int gstate_id;
 
 extern FILE *tl_out;	
 BState *bstack, *bstates, *bremoved;
-BScc *scc_stack;
-int accept, bstate_count = 0, btrans_count = 0, rank;
+static BScc *scc_stack;
+int accept, bstate_count = 0, btrans_count = 0;
+static int rank;
+static int scc_uptodate = 0; /* 1 if the scc data still describes 'bstates' */
 
 /********************************************************************\
 |*        Simplification of the generalized Buchi automaton         *|
@@ -60,6 +66,19 @@ void free_bstate(BState *s) /* frees a state and its transitions */
   tfree(s);
 }
 
+BState *merged_bstate(BState *s)
+{ /* finds the state that replaces a removed state, or 0 if there is none */
+  BState *r = s, *nxt;
+  while(r && !r->trans) /* a removed state points to its replacement */
+    r = r->prv;
+  while(s != r) { /* path compression */
+    nxt = s->prv;
+    s->prv = r;
+    s = nxt;
+  }
+  return r;
+}
+
 BState *remove_bstate(BState *s, BState *s1) /* removes a state */
 {
   BState *prv = s->prv;
@@ -69,10 +88,7 @@ BState *remove_bstate(BState *s, BState *s1) /* removes a state */
   s->trans = (BTrans *)0;
   s->nxt = bremoved->nxt;
   bremoved->nxt = s;
-  s->prv = s1;
-  for(s1 = bremoved->nxt; s1 != bremoved; s1 = s1->nxt)
-    if(s1->prv == s)
-      s1->prv = s->prv;
+  s->prv = s1; /* states merged into s are now merged into s1 */
   return prv;
 } 
 
@@ -82,34 +98,72 @@ void copy_btrans(BTrans *from, BTrans *to) {
   copy_set(from->neg, to->neg, 1);
 }
 
+/* As for the generalized automaton, the transitions of each state are
+   simplified independently, by par_for with the option -j. */
+
+static BState **bpass;
+static BTrans **bpass_removed;
+static int bpass_size = 0;
+
+static void simplify_bstate_trans(int i, void *arg)
+{
+  BState *s = bpass[i];
+  BTrans *t, *t1;
+
+  for (t = s->trans->nxt; t != s->trans;) {
+    t1 = s->trans->nxt;
+    copy_btrans(t, s->trans);
+    while((t == t1) || (t->to != t1->to) ||
+          !included_set(t1->pos, t->pos, 1) ||
+          !included_set(t1->neg, t->neg, 1))
+      t1 = t1->nxt;
+    if(t1 != s->trans) {
+      BTrans *free = t->nxt;
+      t->to    = free->to;
+      copy_set(free->pos, t->pos, 1);
+      copy_set(free->neg, t->neg, 1);
+      t->nxt   = free->nxt;
+      if(free == s->trans) s->trans = t;
+      free->nxt = bpass_removed[i];
+      bpass_removed[i] = free;
+    }
+    else
+      t = t->nxt;
+  }
+}
+
 int simplify_btrans() /* simplifies the transitions */
 {
   BState *s;
-  BTrans *t, *t1;
-  int changed = 0;
+  BTrans *t;
+  int i, n = 0, changed = 0;
 
   if(tl_stats) getrusage(RUSAGE_SELF, &tr_debut);
 
   for (s = bstates->nxt; s != bstates; s = s->nxt)
-    for (t = s->trans->nxt; t != s->trans;) {
-      t1 = s->trans->nxt;
-      copy_btrans(t, s->trans);
-      while((t == t1) || (t->to != t1->to) ||
-            !included_set(t1->pos, t->pos, 1) ||
-            !included_set(t1->neg, t->neg, 1))
-        t1 = t1->nxt;
-      if(t1 != s->trans) {
-        BTrans *free = t->nxt;
-        t->to    = free->to;
-        copy_set(free->pos, t->pos, 1);
-        copy_set(free->neg, t->neg, 1);
-        t->nxt   = free->nxt;
-        if(free == s->trans) s->trans = t;
-        free_btrans(free, 0, 0);
-        changed++;
-      }
-      else
-        t = t->nxt;
+    n++;
+  if(n > bpass_size) {
+    if(bpass_size) {
+      tfree(bpass);
+      tfree(bpass_removed);
+    }
+    bpass_size = 2 * n;
+    bpass = (BState **)tl_emalloc(bpass_size * sizeof(BState *));
+    bpass_removed = (BTrans **)tl_emalloc(bpass_size * sizeof(BTrans *));
+  }
+  for (i = 0, s = bstates->nxt; s != bstates; s = s->nxt, i++) {
+    bpass[i] = s;
+    bpass_removed[i] = (BTrans *)0;
+  }
+
+  par_for(n, simplify_bstate_trans, (void *)0);
+
+  for (i = 0; i < n; i++)
+    while(bpass_removed[i]) {
+      t = bpass_removed[i];
+      bpass_removed[i] = t->nxt;
+      free_btrans(t, 0, 0);
+      changed++;
     }
       
   if(tl_stats) {
@@ -153,9 +207,9 @@ void retarget_all_btrans()
   BState *s;
   BTrans *t;
   for (s = bstates->nxt; s != bstates; s = s->nxt)
-    for (t = s->trans->nxt; t != s->trans; t = t->nxt)
+    for (t = s->trans->nxt; t != s->trans; )
       if (!t->to->trans) { /* t->to has been removed */
-	t->to = t->to->prv;
+	t->to = merged_bstate(t->to);
 	if(!t->to) { /* t->to has no transitions */
 	  BTrans *free = t->nxt;
 	  t->to = free->to;
@@ -165,7 +219,11 @@ void retarget_all_btrans()
 	  if(free == s->trans) s->trans = t;
 	  free_btrans(free, 0, 0);
 	}
+	else
+	  t = t->nxt;
       }
+      else
+	t = t->nxt;
   while(bremoved->nxt != bremoved) { /* clean the 'removed' list */
     s = bremoved->nxt;
     bremoved->nxt = bremoved->nxt->nxt;
@@ -227,6 +285,7 @@ int simplify_bstates() /* eliminates redundant states */
     while(!all_btrans_match(s, s1))
       s1 = s1->nxt;
     if(s1 != bstates) { /* s and s1 are equivalent */
+      scc_uptodate = 0; /* retargeting the transitions may merge sccs */
       /* we now want to remove s and replace it by s1 */
       if(s1->incoming == -1) {  /* s1 is in a trivial SCC */
         s1->final = s->final; /* change the final condition of s1 to that of s */
@@ -289,31 +348,255 @@ int simplify_bstates() /* eliminates redundant states */
   return changed;
 }
 
+/* Direct simulation: q simulates p if q is final when p is, and each
+   transition of p is matched by a transition of q with a weaker guard
+   to a state simulating the target of p's transition. The relation is
+   the greatest fixpoint, computed by removing the pairs which fail.
+   For each transition t of p and each state q, a counter keeps the
+   number of transitions of q matching t; when a pair is removed, the
+   counters of the transitions into its states are decremented, and a
+   pair whose counter falls to 0 is removed in turn. The work is then
+   bounded by the pairs of transitions with the same target pair.
+   Guards are matched one by one, so the relation may miss some pairs,
+   but it is a simulation. States which simulate each other are merged,
+   and a transition is removed when another transition of its state has
+   a weaker guard and a target simulating its target. Both preserve the
+   language of the automaton.
+   The relation is a bitset over the pairs of states, and the counters
+   are short integers: the pass is skipped when they would exceed
+   SIM_MAX_PAIRS bits or SIM_MAX_COUNTERS counters. */
+
+#define SIM_MAX_PAIRS    (1 << 28) /* 32MB */
+#define SIM_MAX_COUNTERS (1 << 24) /* 32MB */
+
+static BState **sim_state;  /* states, by label */
+static unsigned char *sim;  /* bit p * n + q: q simulates p */
+static int sim_n;
+
+static int pair_in(int p, int q)
+{
+  size_t i = (size_t)p * sim_n + q;
+  return (sim[i >> 3] >> (i & 7)) & 1;
+}
+
+static void pair_rem(int p, int q)
+{
+  size_t i = (size_t)p * sim_n + q;
+  sim[i >> 3] &= ~(1 << (i & 7));
+}
+
+static int sim_final(BState *s) /* id == 0 means an accepting well */
+{
+  return s->final == accept || s->id == 0;
+}
+
+static int weaker_guard(BTrans *t, BTrans *u) /* guard of t implies guard of u */
+{
+  return included_set(u->pos, t->pos, 1) && included_set(u->neg, t->neg, 1);
+}
+
+static void compute_bsim(BTrans **tr, int *src, int n_trans)
+{ /* tr[i] is a transition from the state src[i], numbered by state */
+  int n = sim_n, p, q, i, j, k, top = 0, max = 2 * (n + 1);
+  int *first = (int *)emalloc((n + 1) * sizeof(int));
+  int *in_first = (int *)emalloc((n + 1) * sizeof(int));
+  int *in = (int *)emalloc((n_trans + 1) * sizeof(int));
+  int *stack = (int *)emalloc(max * sizeof(int));
+  unsigned short *count =
+    (unsigned short *)emalloc(((size_t)n_trans * n + 1) * sizeof(short));
+
+  /* transitions from each state, and into each state */
+  for(i = 0; i < n_trans; i++) {
+    first[src[i] + 1]++;
+    in_first[tr[i]->to->label + 1]++;
+  }
+  for(p = 0; p < n; p++) {
+    first[p + 1] += first[p];
+    in_first[p + 1] += in_first[p];
+  }
+  for(i = 0; i < n_trans; i++)
+    in[in_first[tr[i]->to->label]++] = i;
+  for(p = n; p > 0; p--) /* each row start moved to the next row */
+    in_first[p] = in_first[p - 1];
+  in_first[0] = 0;
+
+  for(p = 0; p < n; p++)
+    for(q = 0; q < n; q++)
+      if(!sim_final(sim_state[p]) || sim_final(sim_state[q]))
+        sim[((size_t)p * n + q) >> 3] |= 1 << (((size_t)p * n + q) & 7);
+  /* counts the matches of each transition on the initial relation, and
+     queues the pairs with an unmatched transition */
+  for(p = 0; p < n; p++)
+    for(q = 0; q < n; q++) {
+      if(!pair_in(p, q)) continue;
+      for(i = first[p]; i < first[p + 1]; i++) {
+        k = 0;
+        for(j = first[q]; j < first[q + 1]; j++)
+          if(pair_in(tr[i]->to->label, tr[j]->to->label) &&
+             weaker_guard(tr[i], tr[j]))
+            k++;
+        count[(size_t)i * n + q] = k;
+        if(!k) break;
+      }
+      if(i < first[p + 1]) {
+        if(top == max) { /* grows the worklist */
+          int *s = (int *)emalloc(2 * max * sizeof(int));
+          memcpy(s, stack, max * sizeof(int));
+          free(stack);
+          stack = s;
+          max *= 2;
+        }
+        stack[top++] = p;
+        stack[top++] = q;
+      }
+    }
+  for(i = 0; i < top; i += 2)
+    pair_rem(stack[i], stack[i + 1]);
+  /* the transitions into the states of a removed pair lose a match */
+  while(top) {
+    int p1 = stack[top - 2], q1 = stack[top - 1];
+    top -= 2;
+    for(i = in_first[p1]; i < in_first[p1 + 1]; i++)
+      for(j = in_first[q1]; j < in_first[q1 + 1]; j++) {
+        p = src[in[i]];
+        q = src[in[j]];
+        if(!pair_in(p, q) || !weaker_guard(tr[in[i]], tr[in[j]]))
+          continue;
+        if(--count[(size_t)in[i] * n + q]) continue;
+        pair_rem(p, q);
+        if(top == max) {
+          int *s = (int *)emalloc(2 * max * sizeof(int));
+          memcpy(s, stack, max * sizeof(int));
+          free(stack);
+          stack = s;
+          max *= 2;
+        }
+        stack[top++] = p;
+        stack[top++] = q;
+      }
+  }
+  free(first);
+  free(in_first);
+  free(in);
+  free(stack);
+  free(count);
+}
+
+int simplify_bsim() /* reduces the automaton with the direct simulation */
+{
+  BState *s, *r;
+  BTrans *t, *u, **tr;
+  int p, q, i, *src, n_trans = 0, degree = 0, merged = 0, removed = 0;
+
+  for(sim_n = 0, s = bstates->nxt; s != bstates; s = s->nxt, sim_n++) {
+    for(i = 0, t = s->trans->nxt; t != s->trans; t = t->nxt, i++)
+      ;
+    n_trans += i;
+    if(i > degree) degree = i;
+  }
+  if((size_t)sim_n * sim_n > SIM_MAX_PAIRS ||
+     (size_t)n_trans * sim_n > SIM_MAX_COUNTERS || degree > 65535) {
+    if(tl_stats) {
+      fprintf(tl_out, "\nSimplification of the Buchi automaton - simulation: skipped");
+      fprintf(tl_out, "\n%i states, %i transitions: too large\n", sim_n, n_trans);
+    }
+    return 0;
+  }
+
+  if(tl_stats) getrusage(RUSAGE_SELF, &tr_debut);
+
+  sim = (unsigned char *)emalloc(((size_t)sim_n * sim_n + 7) / 8 + 1);
+  sim_state = (BState **)emalloc((sim_n + 1) * sizeof(BState *));
+  tr = (BTrans **)emalloc((n_trans + 1) * sizeof(BTrans *));
+  src = (int *)emalloc((n_trans + 1) * sizeof(int));
+  for(p = 0, i = 0, s = bstates->nxt; s != bstates; s = s->nxt, p++) {
+    s->label = p;
+    sim_state[p] = s;
+    for(t = s->trans->nxt; t != s->trans; t = t->nxt, i++) {
+      tr[i] = t;
+      src[i] = p;
+    }
+  }
+  compute_bsim(tr, src, n_trans);
+  free(tr);
+  free(src);
+
+  /* merges the states which simulate each other into the first one of
+     their class, or into the initial state */
+  for(p = 0; p < sim_n; p++) {
+    s = sim_state[p];
+    if(!s->trans) continue; /* already merged */
+    for(q = 0; q < sim_n; q++)
+      if(pair_in(p, q) && pair_in(q, p) && sim_state[q]->trans &&
+         (sim_state[q]->id == -1 || (q < p && s->id != -1)))
+        break;
+    if(q == sim_n || q == p) continue;
+    r = sim_state[q];
+    remove_bstate(s, r);
+    merged++;
+  }
+  if(merged) {
+    retarget_all_btrans();
+    scc_uptodate = 0;
+  }
+
+  /* removes the transitions made useless by another one of their state */
+  for(s = bstates->nxt; s != bstates; s = s->nxt)
+    for(t = s->trans->nxt; t != s->trans; ) {
+      for(u = s->trans->nxt; u != s->trans; u = u->nxt)
+        if(u != t && weaker_guard(t, u) &&
+           pair_in(t->to->label, u->to->label))
+          break;
+      if(u != s->trans) {
+        BTrans *free = t->nxt;
+        t->to = free->to;
+        copy_set(free->pos, t->pos, 1);
+        copy_set(free->neg, t->neg, 1);
+        t->nxt = free->nxt;
+        if(free == s->trans) s->trans = t;
+        free_btrans(free, 0, 0);
+        removed++;
+        scc_uptodate = 0;
+      }
+      else
+        t = t->nxt;
+    }
+
+  free(sim_state);
+  free(sim);
+
+  if(tl_stats) {
+    getrusage(RUSAGE_SELF, &tr_fin);
+    timeval_subtract (&t_diff, &tr_fin.ru_utime, &tr_debut.ru_utime);
+    fprintf(tl_out, "\nSimplification of the Buchi automaton - simulation: %i.%06is",
+		t_diff.tv_sec, t_diff.tv_usec);
+    fprintf(tl_out, "\n%i states merged, %i transitions removed\n", merged, removed);
+  }
+
+  return merged + removed;
+}
+
 int bdfs(BState *s) {
   BTrans *t;
-  BScc *c;
   BScc *scc = (BScc *)tl_emalloc(sizeof(BScc));
+  int theta;
   scc->bstate = s;
   scc->rank = rank;
   scc->theta = rank++;
   scc->nxt = scc_stack;
   scc_stack = scc;
 
-  s->incoming = 1;
+  s->incoming = scc->rank + 1; /* the state is on the stack */
 
   for (t = s->trans->nxt; t != s->trans; t = t->nxt) {
     if (t->to->incoming == 0) {
       int result = bdfs(t->to);
       scc->theta = min(scc->theta, result);
     }
-    else {
-      for(c = scc_stack->nxt; c != 0; c = c->nxt)
-	if(c->bstate == t->to) {
-	  scc->theta = min(scc->theta, c->rank);
-	  break;
-	}
-    }
+    else if (t->to->incoming > 1) /* on the stack: its rank is incoming - 1 */
+      scc->theta = min(scc->theta, t->to->incoming - 1);
   }
+  theta = scc->theta;
   if(scc->rank == scc->theta) {
     if(scc_stack == scc) { /* s is alone in a scc */
       s->incoming = -1;
@@ -321,13 +604,30 @@ int bdfs(BState *s) {
 	if (t->to == s)
 	  s->incoming = 1;
     }
+    else {
+      while(scc_stack != scc) {
+        BScc *c = scc_stack;
+        c->bstate->incoming = 1;
+        scc_stack = c->nxt;
+        tfree(c);
+      }
+      s->incoming = 1;
+    }
     scc_stack = scc->nxt;
+    tfree(scc);
   }
-  return scc->theta;
+  return theta;
 }
 
 void simplify_bscc() {
   BState *s;
+
+  /* simplify_btrans only removes a transition when another transition
+     with the same source and target remains, and removing states without
+     transitions does not change the other sccs: the scc data computed by
+     the last call is then still exact and need not be computed again */
+  if(scc_uptodate) return;
+
   rank = 1;
   scc_stack = 0;
 
@@ -340,7 +640,8 @@ void simplify_bscc() {
 
   for(s = bstates->nxt; s != bstates; s = s->nxt)
     if(s->incoming == 0)
-      remove_bstate(s, 0);
+      s = remove_bstate(s, 0);
+  scc_uptodate = 1;
 }
 
 
@@ -350,30 +651,178 @@ void simplify_bscc() {
 |*              Generation of the Buchi automaton                   *|
 \********************************************************************/
 
+int next_final(int *set, int fin) /* computes the 'final' value */
+{
+  if((fin != accept) && in_set(set, final[fin + 1]))
+    return next_final(set, fin + 1);
+  return fin;
+}
+
+/* The states created during the construction are indexed by their
+   generalized state and their 'final' value in 'btable', which replaces
+   the search in the stack, the solved and the removed states. */
+
+typedef struct BCell {
+  BState *bstate;
+  struct BCell *nxt;
+} BCell;
+
+static BCell **btable;
+static int btable_size = 0, btable_count = 0;
+
+static unsigned int hash_bstate(GState *gstate, int final)
+{
+  unsigned long h = (unsigned long)gstate / sizeof(GState);
+  return (unsigned int)(h * 31 + final);
+}
+
+static BState *get_btable(GState *gstate, int final)
+{
+  BCell *c;
+  if(!btable_size) return (BState *)0;
+  for(c = btable[hash_bstate(gstate, final) % btable_size]; c; c = c->nxt)
+    if(c->bstate->gstate == gstate && c->bstate->final == final)
+      return c->bstate;
+  return (BState *)0;
+}
+
+static void put_btable(BState *s)
+{
+  BCell *c, *nxt;
+  int i;
+  if(btable_count >= btable_size) { /* grows the table */
+    int size = btable_size ? 2 * btable_size : 64;
+    BCell **table = (BCell **)tl_emalloc(size * sizeof(BCell *));
+    for(i = 0; i < btable_size; i++)
+      for(c = btable[i]; c; c = nxt) {
+        nxt = c->nxt;
+        c->nxt = table[hash_bstate(c->bstate->gstate, c->bstate->final) % size];
+        table[hash_bstate(c->bstate->gstate, c->bstate->final) % size] = c;
+      }
+    if(btable_size) tfree(btable);
+    btable = table;
+    btable_size = size;
+  }
+  c = (BCell *)tl_emalloc(sizeof(BCell));
+  c->bstate = s;
+  c->nxt = btable[hash_bstate(s->gstate, s->final) % btable_size];
+  btable[hash_bstate(s->gstate, s->final) % btable_size] = c;
+  btable_count++;
+}
+
+static void del_btable(BState *s)
+{
+  BCell **c, *free;
+  for(c = &btable[hash_bstate(s->gstate, s->final) % btable_size]; *c; c = &(*c)->nxt)
+    if((*c)->bstate == s) {
+      free = *c;
+      *c = free->nxt;
+      tfree(free);
+      btable_count--;
+      return;
+    }
+}
+
+static void free_btable()
+{
+  BCell *c, *nxt;
+  int i;
+  for(i = 0; i < btable_size; i++)
+    for(c = btable[i]; c; c = nxt) {
+      nxt = c->nxt;
+      tfree(c);
+    }
+  if(btable_size) tfree(btable);
+  btable_size = btable_count = 0;
+}
+
+/* The transitions of a state only depend on its generalized state and
+   its 'final' value. solve_bstate computes which transitions of the
+   generalized state are kept by the on the fly simplification, comparing
+   the targets by their generalized state and 'final' value instead of
+   creating them. It only reads the generalized automaton: with the
+   option -j, it is called in advance by other threads, and uses memory
+   from malloc. */
+
+typedef struct BCand { /* transitions kept, by position in the gstate */
+  int size;
+  int *trans;
+} BCand;
+
+typedef struct BJob {
+  GState *gstate;
+  int final;
+} BJob;
+
+static BCand *solve_bstate(GState *g, int final)
+{
+  int i, j, k = 0, head = -1, *p, *fin, *nxt;
+  GTrans *t, **gtr;
+  BCand *c;
+
+  for(t = g->trans->nxt; t != g->trans; t = t->nxt)
+    k++;
+  c = (BCand *)emalloc(sizeof(BCand) + (k + 1) * sizeof(int));
+  c->trans = (int *)(c + 1);
+  gtr = (GTrans **)emalloc((k + 1) * sizeof(GTrans *));
+  fin = (int *)emalloc((k + 1) * sizeof(int));
+  nxt = (int *)emalloc((k + 1) * sizeof(int));
+  for(i = 0, t = g->trans->nxt; t != g->trans; t = t->nxt, i++) {
+    gtr[i] = t;
+    fin[i] = next_final(t->final, (final == accept) ? 0 : final);
+  }
+
+  for(i = 0; i < k; i++) { /* kept transitions: head, nxt[head], ... */
+    for(p = &head; *p != -1;) {
+      j = *p;
+      if(tl_simp_fly &&
+         (gtr[i]->to == gtr[j]->to) && (fin[i] == fin[j]) &&
+         included_set(gtr[i]->pos, gtr[j]->pos, 1) &&
+         included_set(gtr[i]->neg, gtr[j]->neg, 1)) /* j is redondant */
+        *p = nxt[j];
+      else if(tl_simp_fly &&
+              (gtr[i]->to == gtr[j]->to) && (fin[i] == fin[j]) &&
+              included_set(gtr[j]->pos, gtr[i]->pos, 1) &&
+              included_set(gtr[j]->neg, gtr[i]->neg, 1)) /* i is redondant */
+        break;
+      else
+        p = &nxt[j];
+    }
+    if(*p == -1) {
+      nxt[i] = head;
+      head = i;
+    }
+  }
+
+  for(c->size = 0; head != -1; head = nxt[head])
+    c->trans[c->size++] = head;
+  free(gtr);
+  free(fin);
+  free(nxt);
+  return c;
+}
+
+static void *solve_bjob(void *j, void *mem)
+{
+  return solve_bstate(((BJob *)j)->gstate, ((BJob *)j)->final);
+}
+
+static void free_bjob_result(void *c) { free(c); }
+
+static void push_bjob(BState *s) /* asks the other threads to solve s */
+{
+  BJob *j = (BJob *)emalloc(sizeof(BJob));
+  j->gstate = s->gstate;
+  j->final = s->final;
+  s->job = par_job_push(j);
+}
+
 BState *find_bstate(GState **state, int final, BState *s)
 {                       /* finds the corresponding state, or creates it */
   if((s->gstate == *state) && (s->final == final)) return s; /* same state */
 
-  s = bstack->nxt; /* in the stack */
-  bstack->gstate = *state;
-  bstack->final = final;
-  while(!(s->gstate == *state) || !(s->final == final))
-    s = s->nxt;
-  if(s != bstack) return s;
-
-  s = bstates->nxt; /* in the solved states */
-  bstates->gstate = *state;
-  bstates->final = final;
-  while(!(s->gstate == *state) || !(s->final == final))
-    s = s->nxt;
-  if(s != bstates) return s;
-
-  s = bremoved->nxt; /* in the removed states */
-  bremoved->gstate = *state;
-  bremoved->final = final;
-  while(!(s->gstate == *state) || !(s->final == final))
-    s = s->nxt;
-  if(s != bremoved) return s;
+  s = get_btable(*state, final); /* in the stack, the solved or the removed states */
+  if(s) return s;
 
   s = (BState *)tl_emalloc(sizeof(BState)); /* creates a new state */
   s->gstate = *state;
@@ -384,62 +833,65 @@ BState *find_bstate(GState **state, int final, BState *s)
   s->trans->nxt = s->trans;
   s->nxt = bstack->nxt;
   bstack->nxt = s;
+  put_btable(s);
+  if(tl_jobs > 1 && s->gstate->trans) push_bjob(s);
   return s;
 }
 
-int next_final(int *set, int fin) /* computes the 'final' value */
-{
-  if((fin != accept) && in_set(set, final[fin + 1]))
-    return next_final(set, fin + 1);
-  return fin;
-}
+static BState **make_bto; /* targets of the transitions of a gstate */
+static GTrans **make_gtr; /* transitions of a gstate */
+static int make_size = 0;
 
 void make_btrans(BState *s) /* creates all the transitions from a state */
 {
-  int state_trans = 0;
+  int i, state_trans = 0;
   GTrans *t;
-  BTrans *t1;
+  BTrans *last;
   BState *s1;
-  if(s->gstate->trans)
-    for(t = s->gstate->trans->nxt; t != s->gstate->trans; t = t->nxt) {
-      int fin = next_final(t->final, (s->final == accept) ? 0 : s->final);
-      BState *to = find_bstate(&t->to, fin, s);
-      
-      for(t1 = s->trans->nxt; t1 != s->trans;) {
-	if(tl_simp_fly && 
-	   (to == t1->to) &&
-	   included_set(t->pos, t1->pos, 1) &&
-	   included_set(t->neg, t1->neg, 1)) { /* t1 is redondant */
-	  BTrans *free = t1->nxt;
-	  t1->to->incoming--;
-	  t1->to = free->to;
-	  copy_set(free->pos, t1->pos, 1);
-	  copy_set(free->neg, t1->neg, 1);
-	  t1->nxt   = free->nxt;
-	  if(free == s->trans) s->trans = t1;
-	  free_btrans(free, 0, 0);
-	  state_trans--;
-	}
-	else if(tl_simp_fly &&
-		(t1->to == to ) &&
-		included_set(t1->pos, t->pos, 1) &&
-		included_set(t1->neg, t->neg, 1)) /* t is redondant */
-	  break;
-	else
-	  t1 = t1->nxt;
-      }
-      if(t1 == s->trans) {
-	BTrans *trans = emalloc_btrans();
-	trans->to = to;
-	trans->to->incoming++;
-	copy_set(t->pos, trans->pos, 1);
-	copy_set(t->neg, trans->neg, 1);
-	trans->nxt = s->trans->nxt;
-	s->trans->nxt = trans;
-	state_trans++;
+  BCand *c;
+  if(s->gstate->trans) {
+    if(s->job) {
+      c = (BCand *)par_job_pop(s->job, (void *)0);
+      s->job = 0;
+    }
+    else
+      c = solve_bstate(s->gstate, s->final);
+
+    /* the targets are searched or created in the order of the transitions,
+       even for the transitions that are not kept */
+    for(i = 0, t = s->gstate->trans->nxt; t != s->gstate->trans; t = t->nxt, i++) {
+      if(i == make_size) {
+        BState **b = (BState **)tl_emalloc(2 * (make_size + 8) * sizeof(BState *));
+        GTrans **g = (GTrans **)tl_emalloc(2 * (make_size + 8) * sizeof(GTrans *));
+        if(make_size) {
+          memcpy(b, make_bto, make_size * sizeof(BState *));
+          memcpy(g, make_gtr, make_size * sizeof(GTrans *));
+          tfree(make_bto);
+          tfree(make_gtr);
+        }
+        make_bto = b;
+        make_gtr = g;
+        make_size = 2 * (make_size + 8);
       }
+      make_gtr[i] = t;
+      make_bto[i] = find_bstate(&t->to, next_final(t->final, (s->final == accept) ? 0 : s->final), s);
     }
-  
+
+    last = s->trans;
+    for(i = 0; i < c->size; i++) {
+      BTrans *trans = emalloc_btrans();
+      trans->to = make_bto[c->trans[i]];
+      trans->to->incoming++;
+      copy_set(make_gtr[c->trans[i]]->pos, trans->pos, 1);
+      copy_set(make_gtr[c->trans[i]]->neg, trans->neg, 1);
+      trans->nxt = s->trans;
+      last->nxt = trans;
+      last = trans;
+      state_trans++;
+    }
+    free(c);
+  }
+
   if(tl_simp_fly) {
     if(s->trans == s->trans->nxt) { /* s has no transitions */
       free_btrans(s->trans->nxt, s->trans, 1);
@@ -447,9 +899,6 @@ void make_btrans(BState *s) /* creates all the transitions from a state */
       s->prv = (BState *)0;
       s->nxt = bremoved->nxt;
       bremoved->nxt = s;
-      for(s1 = bremoved->nxt; s1 != bremoved; s1 = s1->nxt)
-	if(s1->prv == s)
-	  s1->prv = (BState *)0;
       return;
     }
     bstates->trans = s->trans;
@@ -463,9 +912,6 @@ void make_btrans(BState *s) /* creates all the transitions from a state */
       s->prv = s1;
       s->nxt = bremoved->nxt;
       bremoved->nxt = s;
-      for(s1 = bremoved->nxt; s1 != bremoved; s1 = s1->nxt)
-	if(s1->prv == s)
-	  s1->prv = s->prv;
       return;
     }
   }
@@ -488,32 +934,39 @@ void print_buchi(BState *s) /* dumps the Buchi automaton */
 
   print_buchi(s->nxt); /* begins with the last state */
 
-  fprintf(tl_out, "state ");
+  out_puts("state ");
   if(s->id == -1)
-    fprintf(tl_out, "init");
+    out_puts("init");
   else {
     if(s->final == accept)
-      fprintf(tl_out, "accept");
-    else
-      fprintf(tl_out, "T%i", s->final);
-    fprintf(tl_out, "_%i", s->id);
+      out_puts("accept");
+    else {
+      out_putc('T');
+      out_putint(s->final);
+    }
+    out_putc('_');
+    out_putint(s->id);
   }
-  fprintf(tl_out, "\n");
+  out_putc('\n');
   for(t = s->trans->nxt; t != s->trans; t = t->nxt) {
     if (empty_set(t->pos, 1) && empty_set(t->neg, 1))
-      fprintf(tl_out, "1");
+      out_putc('1');
     print_set(t->pos, 1);
-    if (!empty_set(t->pos, 1) && !empty_set(t->neg, 1)) fprintf(tl_out, " & ");
+    if (!empty_set(t->pos, 1) && !empty_set(t->neg, 1)) out_puts(" & ");
     print_set(t->neg, 2);
-    fprintf(tl_out, " -> ");
+    out_puts(" -> ");
     if(t->to->id == -1) 
-      fprintf(tl_out, "init\n");
+      out_puts("init\n");
     else {
       if(t->to->final == accept)
-	fprintf(tl_out, "accept");
-      else
-	fprintf(tl_out, "T%i", t->to->final);
-      fprintf(tl_out, "_%i\n", t->to->id);
+	out_puts("accept");
+      else {
+	out_putc('T');
+	out_putint(t->to->final);
+      }
+      out_putc('_');
+      out_putint(t->to->id);
+      out_putc('\n');
     }
   }
 }
@@ -523,29 +976,32 @@ void print_spin_buchi() {
   BState *s;
   int accept_all = 0, init_count = 0;
   if(bstates->nxt == bstates) { /* empty automaton */
-    fprintf(tl_out, "never {    /* ");
+    out_puts("never {    /* ");
     put_uform();
-    fprintf(tl_out, " */\n");
-    fprintf(tl_out, "T0_init:\n");
-    fprintf(tl_out, "\tfalse;\n");
-    fprintf(tl_out, "}\n");
+    out_puts(" */\n");
+    out_puts("T0_init:\n");
+    out_puts("\tfalse;\n");
+    out_puts("}\n");
+    out_flush();
     return;
   }
   if(bstates->nxt->nxt == bstates && bstates->nxt->id == 0) { /* true */
-    fprintf(tl_out, "never {    /* ");
+    out_puts("never {    /* ");
     put_uform();
-    fprintf(tl_out, " */\n");
-    fprintf(tl_out, "accept_init:\n");
-    fprintf(tl_out, "\tif\n");
-    fprintf(tl_out, "\t:: (1) -> goto accept_init\n");
-    fprintf(tl_out, "\tfi;\n");
-    fprintf(tl_out, "}\n");
+    out_puts(" */\n");
+    out_puts("accept_init:\n");
+    out_puts("\tif\n");
+    out_puts("\t:: (1) -> goto accept_init\n");
+    out_puts("\tfi;\n");
+    out_puts("}\n");
+    out_flush();
     return;
   }
 
-  fprintf(tl_out, "never { /* ");
+  out_puts("never { /* ");
   put_uform();
-  fprintf(tl_out, " */\n");
+  out_puts(" */\n");
+  guard_start();
   for(s = bstates->prv; s != bstates; s = s->prv) {
       /* s->id == 0 means s is an accepting well */
     if(s->id == 0) { /* accept_all at the end */
@@ -554,47 +1010,52 @@ void print_spin_buchi() {
     }
     /* The state is an accepting state */
     if(s->final == accept)
-      fprintf(tl_out, "accept_");
-    else fprintf(tl_out, "T%i_", s->final);
+      out_puts("accept_");
+    else { out_putc('T'); out_putint(s->final); out_putc('_'); }
     /* The state is the initial state */
     if(s->id == -1)
-      fprintf(tl_out, "init:\n");
-    else fprintf(tl_out, "S%i:\n", s->id);
+      out_puts("init:\n");
+    else { out_putc('S'); out_putint(s->id); out_puts(":\n"); }
     /* The state has no possible transitions */
     if(s->trans->nxt == s->trans) {
-      fprintf(tl_out, "\tfalse;\n");
+      out_puts("\tfalse;\n");
       continue;
     }
-    fprintf(tl_out, "\tif\n");
+    out_puts("\tif\n");
     for(t = s->trans->nxt; t != s->trans; t = t->nxt) {
       BTrans *t1;
-      fprintf(tl_out, "\t:: (");
-      spin_print_set(t->pos, t->neg);
-      for(t1 = t; t1->nxt != s->trans; )
-          if (t1->nxt->to->id == t->to->id &&
-              t1->nxt->to->final == t->to->final) {
-              fprintf(tl_out, ") || (");
-              spin_print_set(t1->nxt->pos, t1->nxt->neg);
-              t1->nxt = t1->nxt->nxt;
-          }
-          else  t1 = t1->nxt;
-      fprintf(tl_out, ") -> goto ");
+      int g;
+      /* the guards of all the transitions to the same state are printed
+         together, as a sum of products of their disjunction */
+      for(t1 = s->trans->nxt; t1 != t; t1 = t1->nxt)
+          if(t1->to->id == t->to->id && t1->to->final == t->to->final)
+              break;
+      if(t1 != t) continue; /* already printed */
+      g = guard_cube(t->pos, t->neg);
+      for(t1 = t->nxt; t1 != s->trans; t1 = t1->nxt)
+          if(t1->to->id == t->to->id && t1->to->final == t->to->final)
+              g = guard_or(g, guard_cube(t1->pos, t1->neg));
+      out_puts("\t:: (");
+      guard_print_spin(g);
+      out_puts(") -> goto ");
       if(t->to->final == accept)
-          fprintf(tl_out, "accept_");
-      else fprintf(tl_out, "T%i_", t->to->final);
+          out_puts("accept_");
+      else { out_putc('T'); out_putint(t->to->final); out_putc('_'); }
       if(t->to->id == 0)
-          fprintf(tl_out, "all\n");
+          out_puts("all\n");
       else if(t->to->id == -1)
-          fprintf(tl_out, "init\n");
-      else fprintf(tl_out, "S%i\n", t->to->id);
+          out_puts("init\n");
+      else { out_putc('S'); out_putint(t->to->id); out_putc('\n'); }
     }
-    fprintf(tl_out, "\tfi;\n");
+    out_puts("\tfi;\n");
   }
+  guard_stop();
   if(accept_all) {
-    fprintf(tl_out, "accept_all:\n");
-    fprintf(tl_out, "\tskip\n");
+    out_puts("accept_all:\n");
+    out_puts("\tskip\n");
   }
-  fprintf(tl_out, "}\n");
+  out_puts("}\n");
+  out_flush();
 }
 
 
@@ -609,6 +1070,7 @@ void mk_buchi()
   GTrans *t;
   BTrans *t1;
   accept = final[0] - 1;
+  scc_uptodate = 0; /* the scc data of a previous automaton is stale */
   
   if(tl_stats) getrusage(RUSAGE_SELF, &tr_debut);
 
@@ -628,6 +1090,8 @@ void mk_buchi()
   s->gstate = 0;
   s->trans = emalloc_btrans(); /* sentinel */
   s->trans->nxt = s->trans;
+  if(tl_jobs > 1) /* starts the threads solving the states in advance */
+    par_jobs_start(solve_bjob, 0, 0, free_bjob_result);
   for(i = 0; i < init_size; i++) 
     if(init[i])
       for(t = init[i]->trans->nxt; t != init[i]->trans; t = t->nxt) {
@@ -670,12 +1134,22 @@ void mk_buchi()
     s = bstack->nxt;
     bstack->nxt = bstack->nxt->nxt;
     if(!s->incoming) {
+      if(s->job) par_job_drop(s->job);
+      del_btable(s);
       free_bstate(s);
       continue;
     }
     make_btrans(s);
   }
 
+  if(tl_jobs > 1) par_jobs_stop();
+  free_btable();
+  if(make_size) {
+    tfree(make_bto);
+    tfree(make_gtr);
+    make_size = 0;
+  }
+
   retarget_all_btrans();
 
   if(tl_stats) {
@@ -689,6 +1163,7 @@ void mk_buchi()
   if(tl_verbose) {
     fprintf(tl_out, "\nBuchi automaton before simplification\n");
     print_buchi(bstates->nxt);
+    out_flush();
     if(bstates == bstates->nxt) 
       fprintf(tl_out, "empty automaton, refuses all words\n");  
   }
@@ -696,7 +1171,14 @@ void mk_buchi()
   if(tl_simp_diff) {
     simplify_btrans();
     if(tl_simp_scc) simplify_bscc();
-    while(simplify_bstates()) { /* simplifies as much as possible */
+    /* simplifies as much as possible */
+    while(1) { /* the simulation pass runs once the states are stable */
+      while(simplify_bstates()) {
+        simplify_btrans();
+        if(tl_simp_scc) simplify_bscc();
+      }
+      if(!tl_simp_sim || !simplify_bsim())
+        break;
       simplify_btrans();
       if(tl_simp_scc) simplify_bscc();
     }
@@ -704,12 +1186,18 @@ void mk_buchi()
     if(tl_verbose) {
       fprintf(tl_out, "\nBuchi automaton after simplification\n");
       print_buchi(bstates->nxt);
+      out_flush();
       if(bstates == bstates->nxt) 
 	fprintf(tl_out, "empty automaton, refuses all words\n");
       fprintf(tl_out, "\n");
     }
   }
 
+  if(tl_trace_count) { /* the automaton is used to check traces */
+    check_traces();
+    return;
+  }
+
   switch (tl_type) {
   case OT_C:
       print_c_buchi();
@@ -717,6 +1205,18 @@ void mk_buchi()
   case OT_JSON:
       print_json_buchi();
       break;
+  case OT_HOA:
+      print_hoa_buchi();
+      break;
+  case OT_BIN:
+      print_bin_buchi();
+      break;
+  case OT_CMON:
+      print_cmon_buchi();
+      break;
+  case OT_CBATCH:
+      print_cbatch_buchi();
+      break;
   default:
       print_spin_buchi();
   }
@@ -19,8 +19,8 @@ const char* assert_str = "__ESBMC_assert";
 const char* nondet_str = "nondet_uint";
 
 int n_ba_state; /* Number of states in the ba */
-BScc *scc_stack; /* Stack used for automaton explorations */
-_Bool *stutter_acceptance_table;
+_Bool *stutter_acceptance_table; /* Stutter acceptance, by class and state */
+_Bool *surely_accept_table, *surely_reject_table; /* By state */
 
 /* Count the number of state in a BA */
 int
@@ -49,112 +49,381 @@ is_transition_valid(BTrans *t, int *prop_state) {
 
 /* Determine whether the stutter extension of a word is accepted,
    given a state and a final program state (i.e a predicate valuation).
-   WARNING : Use of the incoming field, does not anymore represent the scc...
-   Explore the automaton using only the transition compatibles with the final program state.
-   When a cycle containing a final state is found, mark all states leading to it
-   as stutter accepting.
+   The valuations are not enumerated : two valuations enabling the same
+   transitions have the same stutter acceptance, so the valuations are
+   grouped in classes, the leaves of a decision tree which only tests
+   the atomic propositions some guard still depends on.
+   For each class, the automaton restricted to the enabled transitions
+   is split in strongly connected components : a state is stutter
+   accepting if it reaches a non trivial component containing a final state.
 */
-void
-stutter_acceptance_state(BState *s, int *stutter_state) {
 
-    BTrans *t;
-    BScc *c;
-    BScc *scc = (BScc *)tl_emalloc(sizeof(BScc));
+/* Node of the decision tree on the atomic propositions */
+typedef struct CNode {
+    int sym;    /* proposition tested, -1 for a leaf */
+    int yes;    /* node when the proposition is true, class of a leaf */
+    int no;     /* node when the proposition is false */
+} CNode;
+
+#define CLASS_HASH 4096
+
+static BState **c_state;    /* states, by label */
+static BTrans **c_trans;    /* transitions, numbered state by state */
+static int *c_first;        /* transitions of the state of label s are
+                               c_first[s] to c_first[s + 1] - 1 */
+static int n_trans, trans_words;
+static CNode *c_tree;
+static int tree_size, tree_max;
+static unsigned int **c_class; /* transitions enabled in each class */
+static int n_class, class_max, *class_next;
+static int class_head[CLASS_HASH];
+
+/* Return the class of the valuations enabling the transitions
+   'enabled', which is created if needed */
+int
+find_class(unsigned int *enabled) {
+    unsigned int h = 0;
+    int i, k;
+    unsigned int **classes;
+    int *next;
+
+    for (i = 0; i < trans_words; i++)
+        h = h * 31 + enabled[i];
+    h %= CLASS_HASH;
+    for (k = class_head[h]; k != -1; k = class_next[k])
+        if (!memcmp(c_class[k], enabled, trans_words * sizeof(int)))
+            return k;
+
+    if (n_class == class_max) {
+        class_max = class_max ? 2 * class_max : 16;
+        classes = (unsigned int **)tl_emalloc(class_max * sizeof(unsigned int *));
+        next = (int *)tl_emalloc(class_max * sizeof(int));
+        for (k = 0; k < n_class; k++) {
+            classes[k] = c_class[k];
+            next[k] = class_next[k];
+        }
+        if (n_class) {
+            tfree(c_class);
+            tfree(class_next);
+        }
+        c_class = classes;
+        class_next = next;
+    }
+    c_class[n_class] = (unsigned int *)tl_emalloc(trans_words * sizeof(int));
+    memcpy(c_class[n_class], enabled, trans_words * sizeof(int));
+    class_next[n_class] = class_head[h];
+    class_head[h] = n_class;
+    return n_class++;
+}
 
-    /* Mark the state and add it in the stack */
-    s->incoming = 1;
-    scc->bstate = s;
-    scc->nxt = scc_stack;
+/* Build the decision tree below a partial valuation : the propositions
+   of 'tv' are true, the ones of 'fv' are false. Return the new node. */
+int
+build_class_tree(int *tv, int *fv) {
+    int i, j, t, node, sym = -1;
+    CNode *tree;
+    unsigned int *enabled = (unsigned int *)tl_emalloc(trans_words * sizeof(int));
+
+    for (t = 0; t < n_trans; t++) {
+        /* The guard is false */
+        if (!empty_intersect_sets(c_trans[t]->pos, fv, 1) ||
+            !empty_intersect_sets(c_trans[t]->neg, tv, 1))
+            continue;
+        /* The guard is true */
+        if (included_set(c_trans[t]->pos, tv, 1) &&
+            included_set(c_trans[t]->neg, fv, 1)) {
+            enabled[t / 32] |= 1u << t % 32;
+            continue;
+        }
+        /* The guard is undecided : test one of its propositions */
+        if (sym == -1)
+            for (i = 0; i < sym_size && sym == -1; i++)
+                for (j = 0; j < mod; j++)
+                    if (((c_trans[t]->pos[i] | c_trans[t]->neg[i]) &
+                         ~(tv[i] | fv[i])) & (1 << j)) {
+                        sym = mod * i + j;
+                        break;
+                    }
+    }
 
-    /* Invariant : It is possible to reach the current state from
-       every state on the stack */
-    scc_stack = scc;
+    if (tree_size == tree_max) {
+        tree_max = tree_max ? 2 * tree_max : 16;
+        tree = (CNode *)tl_emalloc(tree_max * sizeof(CNode));
+        if (tree_size) {
+            memcpy(tree, c_tree, tree_size * sizeof(CNode));
+            tfree(c_tree);
+        }
+        c_tree = tree;
+    }
+    node = tree_size++;
+    c_tree[node].sym = sym;
+
+    if (sym == -1)
+        c_tree[node].yes = find_class(enabled);
+    else {
+        add_set(tv, sym);
+        t = build_class_tree(tv, fv);
+        c_tree[node].yes = t;
+        rem_set(tv, sym);
+        add_set(fv, sym);
+        t = build_class_tree(tv, fv);
+        c_tree[node].no = t;
+        rem_set(fv, sym);
+    }
+    tfree(enabled);
+    return node;
+}
 
-    /* Visit every successors reachable with the program state */
-    for (t = s->trans->nxt; t != s->trans; t = t->nxt) {
-        if (! is_transition_valid(t, stutter_state))
+/* Mark in 'row' the states having an accepting run using only the
+   'enabled' transitions, with an iterative Tarjan's algorithm.
+   The components are completed successors first, so a state is
+   good if its own component is a cycle with a final state, or if it
+   has an enabled transition to a good state.
+   It may run on the threads of par_for : the marks of the exploration
+   are in arrays allocated with emalloc. */
+void
+good_states(unsigned int *enabled, _Bool *row) {
+    int root, s, d, t, m, i, top = 0, depth, n = 0, n_scc = 0;
+    int *index = (int *)emalloc(6 * (n_ba_state + 1) * sizeof(int));
+    int *low = index + n_ba_state + 1;
+    int *comp = low + n_ba_state + 1;
+    int *stack = comp + n_ba_state + 1;
+    int *call = stack + n_ba_state + 1;
+    int *next_trans = call + n_ba_state + 1;
+    _Bool cycle, final, good;
+
+    for (s = 0; s < n_ba_state; s++) {
+        index[s] = -1;
+        comp[s] = -1;
+    }
+    for (root = 0; root < n_ba_state; root++) {
+        if (index[root] != -1)
             continue;
-
-        /* The successor have not been reached already */
-        if (t->to->incoming == 0) {
-            stutter_acceptance_state(t->to, stutter_state);
-            /* If the successor is stutter-accepted */
-            if (t->to->incoming == 3) {
-                s->incoming = 3;
-                scc_stack = scc_stack->nxt;
-                return;
-            }
-        /* The successor is currently being visited : we found a cycle */
-        } else if (t->to->incoming == 1) {
-            /* Search for a final state in the cycle */
-            _Bool final_cycle = 0;
-            for(c = scc_stack; c != 0; c = c->nxt) {
-                if (c->bstate->final == accept || c->bstate->id == 0)
-                    final_cycle = 1;
-                if (c->bstate == t->to)
+        index[root] = low[root] = n++;
+        next_trans[root] = c_first[root];
+        stack[top++] = root;
+        depth = 0;
+        call[depth++] = root;
+
+        while (depth) {
+            s = call[depth - 1];
+            for (t = next_trans[s]; t < c_first[s + 1]; t++)
+                if (enabled[t / 32] >> t % 32 & 1)
                     break;
+            if (t < c_first[s + 1]) {
+                /* Follow the transition t */
+                next_trans[s] = t + 1;
+                d = c_trans[t]->to->label;
+                if (index[d] == -1) {
+                    index[d] = low[d] = n++;
+                    next_trans[d] = c_first[d];
+                    stack[top++] = d;
+                    call[depth++] = d;
+                }
+                /* d is still on the stack */
+                else if (comp[d] == -1 && index[d] < low[s])
+                    low[s] = index[d];
+                continue;
             }
-            /* If there is final state in the cycle, all the state in the cycle are
-               accepted. We mark the current one, others will be marked recursively */
-            if (final_cycle) {
-                s->incoming = 3;
-                scc_stack = scc_stack->nxt;
-                return;
-            }
-        /* The successor has already been visited */
-        } else {
-            /* If the successor lead to a final cycle, marks all the state as accepting */
-            if (t->to->incoming == 3) {
-                s->incoming = 3;
-                scc_stack = scc_stack->nxt;
-                return;
+
+            /* All the successors of s have been visited */
+            depth--;
+            if (depth && low[s] < low[call[depth - 1]])
+                low[call[depth - 1]] = low[s];
+            if (low[s] != index[s])
+                continue;
+
+            /* s is the root of a component : the states above it on the stack */
+            for (m = top - 1; stack[m] != s; m--)
+                comp[stack[m]] = n_scc;
+            comp[s] = n_scc;
+            cycle = final = good = 0;
+            for (i = m; i < top; i++) {
+                d = stack[i];
+                /* id == 0 means an accepting well */
+                if (c_state[d]->final == accept || c_state[d]->id == 0)
+                    final = 1;
+                for (t = c_first[d]; t < c_first[d + 1]; t++) {
+                    if (!(enabled[t / 32] >> t % 32 & 1))
+                        continue;
+                    if (comp[c_trans[t]->to->label] == n_scc)
+                        cycle = 1;
+                    else if (row[c_trans[t]->to->label])
+                        good = 1;
+                }
             }
+            if (cycle && final)
+                good = 1;
+            for (i = m; i < top; i++)
+                row[stack[i]] = good;
+            top = m;
+            n_scc++;
         }
     }
+    free(index);
+}
 
-    /* If no final cycle have been found, there is none from this state */
-    if (s->incoming == 1) {
-        s->incoming = 2;
-        scc_stack = scc_stack->nxt;
-    }
+/* Compute the stutter acceptance of every state for the class k :
+   the classes are independent, and each one writes its own row */
+void
+stutter_acceptance_class(int k, void *arg) {
+    good_states(c_class[k], stutter_acceptance_table + k * n_ba_state);
 }
 
-/* Compute the stutter acceptance for all automaton state and all final
-   program state */
+/* Compute the classes of valuations, and the stutter acceptance for
+   all automaton state and all class */
 void
 stutter_acceptance() {
     BState *s;
-    scc_stack = 0;
+    BTrans *t;
     int i, k;
-    int stutter_state[sym_size];
+    int *tv = new_set(1), *fv = new_set(1);
 
-    if (sym_size > 1)
-        fatal("c_printer, stutter_acceptance", "sym_size > 1 : too many states for an exploration");
+    /* Number the states and their transitions */
+    n_trans = 0;
+    for (s = bstates->prv; s != bstates; s = s->prv)
+        for (t = s->trans->nxt; t != s->trans; t = t->nxt)
+            n_trans++;
+    trans_words = n_trans / 32 + 1;
+    c_state = (BState **)tl_emalloc((n_ba_state + 1) * sizeof(BState *));
+    c_trans = (BTrans **)tl_emalloc((n_trans + 1) * sizeof(BTrans *));
+    c_first = (int *)tl_emalloc((n_ba_state + 1) * sizeof(int));
+    for (s = bstates->prv, i = 0, k = 0; s != bstates; s = s->prv, i++) {
+        s->label = i;
+        c_state[i] = s;
+        c_first[i] = k;
+        for (t = s->trans->nxt; t != s->trans; t = t->nxt)
+            c_trans[k++] = t;
+    }
+    c_first[n_ba_state] = k;
 
-    if(bstates == bstates->nxt)
-        return;
+    /* Group the valuations in classes */
+    for (k = 0; k < CLASS_HASH; k++)
+        class_head[k] = -1;
+    n_class = class_max = tree_size = tree_max = 0;
+    build_class_tree(tv, fv);
 
-    for (k = 0; k < (1 << sym_id); k++) {
-        stutter_state[0] = k;
+    stutter_acceptance_table = (_Bool *)tl_emalloc((n_class * n_ba_state + 1) * sizeof(_Bool));
+    par_for(n_class, stutter_acceptance_class, (void *)0);
 
-        /* Unmark all states */
-        for (s = bstates->nxt; s != bstates; s = s->nxt)
-            s->incoming = 0;
+    tfree(tv);
+    tfree(fv);
+}
 
-        /* Explore the graph from every state */
-        for (s = bstates->nxt; s != bstates; s = s->nxt) {
-            if (s->incoming == 0)
-                stutter_acceptance_state(s, stutter_state);
-        }
+/* Return true if, for every valuation, a transition from the state of
+   label s leads to a state of 'target' : every class of valuations
+   enables one of them */
+_Bool
+all_valuations_lead_to(int s, _Bool *target) {
+    int k, t;
+
+    for (k = 0; k < n_class; k++) {
+        for (t = c_first[s]; t < c_first[s + 1]; t++)
+            if ((c_class[k][t / 32] >> t % 32 & 1) && target[c_trans[t]->to->label])
+                break;
+        if (t == c_first[s + 1])
+            return 0;
+    }
+    return 1;
+}
 
-        /* Collect the results */
-        for (s = bstates->nxt, i=0; s != bstates; s = s->nxt, i++) {
-            if (s->incoming == 3)
-                stutter_acceptance_table[k * n_ba_state + i] = 1;
-            else
-                stutter_acceptance_table[k * n_ba_state + i] = 0;
-        }
+/* Compute the states from which every suffix is rejected, and the
+   states from which every suffix is accepted.
+   A state surely rejects if no accepting run starts from it.
+   Universality is too costly in general, so the surely accepting
+   states are the ones from which the automaton wins the Buchi game
+   where each valuation is chosen first, then a transition enabled by
+   it : the greatest set Z such that from Z, whatever the valuations,
+   some run reaches a final state of Z, then Z again.
+   This is sound, and it finds the accepting wells. */
+void
+surely_tables() {
+    int s, changed;
+    _Bool *z, *y;
+    unsigned int *all = (unsigned int *)tl_emalloc(trans_words * sizeof(int));
+
+    surely_reject_table = (_Bool *)tl_emalloc((n_ba_state + 1) * sizeof(_Bool));
+    surely_accept_table = (_Bool *)tl_emalloc((n_ba_state + 1) * sizeof(_Bool));
+    y = (_Bool *)tl_emalloc((n_ba_state + 1) * sizeof(_Bool));
+
+    /* The transitions whose guard can be satisfied */
+    for (s = 0; s < n_trans; s++)
+        if (empty_intersect_sets(c_trans[s]->pos, c_trans[s]->neg, 1))
+            all[s / 32] |= 1u << s % 32;
+    good_states(all, surely_reject_table);
+    for (s = 0; s < n_ba_state; s++)
+        surely_reject_table[s] = !surely_reject_table[s];
+
+    /* z = nu Z. mu Y. (final and leads to Z) or (leads to Y) */
+    z = surely_accept_table;
+    for (s = 0; s < n_ba_state; s++)
+        z[s] = 1;
+    do {
+        for (s = 0; s < n_ba_state; s++)
+            y[s] = 0;
+        do {
+            changed = 0;
+            for (s = 0; s < n_ba_state; s++) {
+                if (y[s])
+                    continue;
+                /* id == 0 means an accepting well */
+                if (((c_state[s]->final == accept || c_state[s]->id == 0) &&
+                     all_valuations_lead_to(s, z)) ||
+                    all_valuations_lead_to(s, y))
+                    y[s] = changed = 1;
+            }
+        } while (changed);
+        for (s = 0; s < n_ba_state; s++)
+            if (z[s] && !y[s]) {
+                z[s] = 0;
+                changed = 1;
+            }
+    } while (changed);
+
+    tfree(all);
+    tfree(y);
+}
+
+/* Compute the tables of the stutter acceptance and of the surely
+   accepting and rejecting states, also used to check traces */
+void
+build_stutter_tables() {
+
+    n_ba_state = count_ba_states();
+    stutter_acceptance();
+    surely_tables();
+}
+
+/* Return the class of a valuation of the atomic propositions.
+   It only reads the decision tree, so it may run on the threads */
+int
+stutter_class(int *valuation) {
+    int node = 0, sym;
+
+    while ((sym = c_tree[node].sym) != -1)
+        node = (valuation[sym / mod] >> sym % mod & 1) ?
+            c_tree[node].yes : c_tree[node].no;
+    return c_tree[node].yes;
+}
+
+/* Free the classes and the tables of the stutter acceptance */
+void
+free_stutter_acceptance() {
+    int k;
+
+    for (k = 0; k < n_class; k++)
+        tfree(c_class[k]);
+    if (class_max) {
+        tfree(c_class);
+        tfree(class_next);
     }
+    tfree(c_tree);
+    tfree(c_state);
+    tfree(c_trans);
+    tfree(c_first);
+    tfree(stutter_acceptance_table);
+    tfree(surely_accept_table);
+    tfree(surely_reject_table);
 }
 
 /* Print the condition of a transition */
@@ -166,19 +435,21 @@ c_print_set(int* pos, int* neg) {
         for(j = 0; j < mod; j++) {
             if(pos[i] & (1 << j)) {
                 if(!start)
-                    fprintf(tl_out, " && ");
-                fprintf(tl_out, "_ltl2ba_atomic_%s", sym_table[mod * i + j]);
+                    out_puts(" && ");
+                out_puts("_ltl2ba_atomic_");
+                out_puts(sym_table[mod * i + j]);
                 start = 0;
             }
             if(neg[i] & (1 << j)) {
                 if(!start)
-                    fprintf(tl_out, " && ");
-                fprintf(tl_out, "!_ltl2ba_atomic_%s", sym_table[mod * i + j]);
+                    out_puts(" && ");
+                out_puts("!_ltl2ba_atomic_");
+                out_puts(sym_table[mod * i + j]);
                 start = 0;
             }
         }
     if(start)
-        fprintf(tl_out, "1");
+        out_putc('1');
 }
 
 /* Print variables for each atomic predicate */
@@ -186,9 +457,36 @@ void
 print_c_atomics_definition() {
     int i;
     for (i = 0; i < sym_id; i++) {
-        fprintf(tl_out, "_Bool _ltl2ba_atomic_%s = 0;\n", sym_table[i]);
+        out_puts("_Bool _ltl2ba_atomic_");
+        out_puts(sym_table[i]);
+        out_puts(" = 0;\n");
+    }
+    out_putc('\n');
+}
+
+/* Print a C function packing the atomic predicates in words of bits :
+   the predicate sym_table[i] is the bit i % mod of the word i / mod,
+   as in the sets of the automata */
+void
+print_c_valuation_function() {
+    int i;
+
+    out_puts("void\n_ltl2ba_valuation(unsigned int *v) {\n");
+    out_puts("\tint w;\n");
+    out_puts("\tfor (w = 0; w < ");
+    out_putint(sym_size);
+    out_puts("; w++)\n");
+    out_puts("\t\tv[w] = 0;\n");
+    for (i = 0; i < sym_id; i++) {
+        out_puts("\tv[");
+        out_putint(i / mod);
+        out_puts("] |= (unsigned int)_ltl2ba_atomic_");
+        out_puts(sym_table[i]);
+        out_puts(" << ");
+        out_putint(i % mod);
+        out_puts(";\n");
     }
-    fprintf(tl_out, "\n");
+    out_puts("}\n\n");
 }
 
 /* Print an enumeration containing the ba states */
@@ -196,10 +494,15 @@ void
 print_c_states_definition() {
     BState *s;
 
-    fprintf(tl_out, "typedef enum {\n");
-    for (s = bstates->prv; s != bstates; s = s->prv)
-        fprintf(tl_out, "\t_ltl2ba_state_%i_%i,\n", s->id + 1, s->final);
-    fprintf(tl_out, "} _ltl2ba_state;\n\n");
+    out_puts("typedef enum {\n");
+    for (s = bstates->prv; s != bstates; s = s->prv) {
+        out_puts("\t_ltl2ba_state_");
+        out_putint(s->id + 1);
+        out_putc('_');
+        out_putint(s->final);
+        out_puts(",\n");
+    }
+    out_puts("} _ltl2ba_state;\n\n");
 }
 
 /* Print the transition function of the ba */
@@ -208,204 +511,213 @@ print_c_transition_function() {
     BState *s;
     BTrans *t;
 
-    fprintf(tl_out, "void\n_ltl2ba_transition() {\n");
+    out_puts("void\n_ltl2ba_transition() {\n");
 
     /* If the automaton is empty (no states) */
     if (bstates->nxt == bstates) {
-        fprintf(tl_out, "\t%s(0);\n}\n", assume_str);
+        out_putc('\t');
+        out_puts(assume_str);
+        out_puts("(0);\n}\n");
         return;
     }
 
-    fprintf(tl_out, "\tint choice = %s();\n", nondet_str);
-    fprintf(tl_out, "\tswitch (_ltl2ba_state_var) {\n");
+    out_puts("\tint choice = ");
+    out_puts(nondet_str);
+    out_puts("();\n");
+    out_puts("\tswitch (_ltl2ba_state_var) {\n");
 
     for(s = bstates->prv; s != bstates; s = s->prv) {
-        fprintf(tl_out, "\tcase _ltl2ba_state_%i_%i:\n", s->id + 1, s->final);
-
-        /* The state of id 0 is an accepting well.
-           Every word will be accepted and the state will no longer change
+        out_puts("\tcase _ltl2ba_state_");
+        out_putint(s->id + 1);
+        out_putc('_');
+        out_putint(s->final);
+        out_puts(":\n");
+
+        /* Every word will be accepted from this state (e.g. the accepting
+           well of id 0), whatever the suffix : the verdict is known
         */
-        if(s->id == 0) {
-            fprintf(tl_out, "\t\t%s(0, \"Error sure\");\n", assert_str);
-            fprintf(tl_out, "\t\tbreak;\n");
+        if(surely_accept_table[s->label]) {
+            out_puts("\t\t");
+            out_puts(assert_str);
+            out_puts("(0, \"Error sure\");\n");
+            out_puts("\t\tbreak;\n");
             continue;
         }
 
-        /* If there is no transition from this state */
+        /* If there is no transition from this state, or if every word
+           will be rejected from it */
         t = s->trans->nxt;
-        if(t == s->trans) {
-            fprintf(tl_out, "\t\t%s(0);\n", assume_str);
+        if(t == s->trans || surely_reject_table[s->label]) {
+            out_puts("\t\t");
+            out_puts(assume_str);
+            out_puts("(0);\n");
             continue;
         }
 
         /* First transition from the current state */
-        fprintf(tl_out, "\t\tif (choice == 0) {\n");
-        fprintf(tl_out, "\t\t\t%s(", assume_str);
+        out_puts("\t\tif (choice == 0) {\n");
+        out_puts("\t\t\t");
+        out_puts(assume_str);
+        out_putc('(');
         c_print_set(t->pos, t->neg);
-        fprintf(tl_out, ");\n");
-        fprintf(tl_out, "\t\t\t_ltl2ba_state_var = _ltl2ba_state_%i_%i;\n",
-                t->to->id + 1, t->to->final);
-        fprintf(tl_out, "\t\t}");
+        out_puts(");\n");
+        out_puts("\t\t\t_ltl2ba_state_var = _ltl2ba_state_");
+        out_putint(t->to->id + 1);
+        out_putc('_');
+        out_putint(t->to->final);
+        out_puts(";\n");
+        out_puts("\t\t}");
 
         /* Other transition from the current state */
         int trans_num;
         for(trans_num = 1, t = s->trans->nxt->nxt; t != s->trans; t = t->nxt, trans_num++) {
-            fprintf(tl_out, " else if (choice == %i) {\n", trans_num);
-            fprintf(tl_out, "\t\t\t%s(", assume_str);
+            out_puts(" else if (choice == ");
+            out_putint(trans_num);
+            out_puts(") {\n");
+            out_puts("\t\t\t");
+            out_puts(assume_str);
+            out_putc('(');
             c_print_set(t->pos, t->neg);
-            fprintf(tl_out, ");\n");
-            fprintf(tl_out, "\t\t\t_ltl2ba_state_var = _ltl2ba_state_%i_%i;\n",
-                    t->to->id + 1, t->to->final);
-            fprintf(tl_out, "\t\t}");
+            out_puts(");\n");
+            out_puts("\t\t\t_ltl2ba_state_var = _ltl2ba_state_");
+            out_putint(t->to->id + 1);
+            out_putc('_');
+            out_putint(t->to->final);
+            out_puts(";\n");
+            out_puts("\t\t}");
         }
         /* Prune other choices */
-        fprintf(tl_out, " else {\n");
-        fprintf(tl_out, "\t\t\t%s(0);\n", assume_str);
-        fprintf(tl_out, "\t\t}");
+        out_puts(" else {\n");
+        out_puts("\t\t\t");
+        out_puts(assume_str);
+        out_puts("(0);\n");
+        out_puts("\t\t}");
 
-        fprintf(tl_out, "\n\t\tbreak;\n");
+        out_puts("\n\t\tbreak;\n");
     }
 
-    fprintf(tl_out, "\t}\n}\n\n");
+    out_puts("\t}\n}\n\n");
 }
 
-/* Print the table indicating if from the current state,
-   every word will be accepted (whatever the suffix)
-*/
+/* Print a table of booleans, by state */
 void
-print_c_surely_accept_state_table() {
-    BState *s;
-
-    fprintf(tl_out, "_Bool _ltl2ba_surely_accept[%i] = {", n_ba_state);
-
-    /* No states in the ba */
-    if (bstates->prv == bstates) {
-        fprintf(tl_out, "};\n");
-        return;
-    }
+print_c_state_table(const char *name, _Bool *table) {
+    int i;
 
-    /* First state */
-    s = bstates->prv;
-    if (s->id == 0)
-        fprintf(tl_out, "1");
-    else
-        fprintf(tl_out, "0");
-
-    /* Following states */
-    for (s = s->prv; s != bstates; s = s->prv) {
-        /* TODO : is this true ??? It is the case only if the automaton is in reduced form... */
-        /* As the automaton is in reduced form, only an accepting well
-           will accept every words whatever the suffix.
-           Accepting well have an id = 0 */
-        if (s->id == 0)
-            fprintf(tl_out, ", 1");
-        else
-            fprintf(tl_out, ", 0");
+    out_puts("_Bool _ltl2ba_");
+    out_puts(name);
+    out_putc('[');
+    out_putint(n_ba_state);
+    out_puts("] = {");
+    for (i = 0; i < n_ba_state; i++) {
+        if (i)
+            out_puts(", ");
+        out_putint(table[i]);
     }
-    fprintf(tl_out, "};\n");
+    out_puts("};\n");
 }
 
-/* Print the table indicating if from the current state,
-   every word will be rejected (whatever the suffix)
-*/
+/* Print the table indicating if the stutter extension of the word read
+   is accepted, by class of the last valuation and by state */
 void
-print_c_surely_reject_state_table() {
-    BState *s;
+print_c_stutter_acceptance_table() {
+    int i, k;
 
-    fprintf(tl_out, "_Bool _ltl2ba_surely_reject[%i] = {", n_ba_state);
+    out_puts("_Bool _ltl2ba_stutter_accept[");
+    out_putint(n_ba_state * n_class);
+    out_puts("] = {");
 
-    /* No states in the ba */
-    if (bstates->prv == bstates) {
-        fprintf(tl_out, "};\n");
-        return;
+    for (k = 0; k < n_class; k++) {
+        out_puts("\n\t");
+        for (i = 0; i < n_ba_state; i++) {
+            out_putint(stutter_acceptance_table[k * n_ba_state + i]);
+            out_putc(',');
+        }
     }
 
-    /* First state */
-    s = bstates->prv;
-    fprintf(tl_out, "0");
-
-    /* Following states */
-    for (s = s->prv; s != bstates; s = s->prv) {
-        /* TODO : is this true ??? It is the case only if the automaton is in reduced form... */
-        /* As the automaton is in reduced form,
-           no state will reject every suffix (elsewhere, this state would have been removed
-           from the automaton) */
-        fprintf(tl_out, ", 0");
-    }
-    fprintf(tl_out, "};\n");
+    out_puts("\n};\n");
 }
 
+/* Print the decision tree of a node, with the given indentation */
 void
-print_c_stutter_acceptance_table() {
-    BState *s;
-    int i, k;
-
-    fprintf(tl_out, "_Bool _ltl2ba_stutter_accept[%i] = {",
-            n_ba_state * (1 << sym_id));
+print_c_class_tree(int node, int depth) {
+    int i;
 
-    /* Other states */
-    for (k = 0; k < (1 << sym_id); k++) {
-        fprintf(tl_out, "\n\t");
-        for (s = bstates->prv, i = n_ba_state - 1; s != bstates; s = s->prv, i--)
-            fprintf(tl_out, "%i,", stutter_acceptance_table[k * n_ba_state + i]);
+    for (i = 0; i < depth; i++)
+        out_putc('\t');
+    if (c_tree[node].sym == -1) {
+        out_puts("return ");
+        out_putint(c_tree[node].yes);
+        out_puts(";\n");
+        return;
     }
-
-    fprintf(tl_out, "\n};\n");
+    out_puts("if (_ltl2ba_atomic_");
+    out_puts(sym_table[c_tree[node].sym]);
+    out_puts(") {\n");
+    print_c_class_tree(c_tree[node].yes, depth + 1);
+    for (i = 0; i < depth; i++)
+        out_putc('\t');
+    out_puts("} else {\n");
+    print_c_class_tree(c_tree[node].no, depth + 1);
+    for (i = 0; i < depth; i++)
+        out_putc('\t');
+    out_puts("}\n");
 }
 
-/* Print a C function that build a program state id from the value of atomic predicates */
-void print_c_sym_to_id_function() {
-
-    int i;
-    fprintf(tl_out, "unsigned int\n");
-    fprintf(tl_out, "_ltl2ba_sym_to_id() {\n");
-
-    fprintf(tl_out, "\tunsigned int id = 0;\n\n");
+/* Print a C function that gives the class of the current valuation of
+   the atomic predicates */
+void
+print_c_class_function() {
 
-    for (i = 0; i < sym_id; i++) {
-        fprintf(tl_out, "\tid |= (_ltl2ba_atomic_%s << %i);\n", sym_table[i], i);
-    }
-    fprintf(tl_out, "\treturn id;\n");
-    fprintf(tl_out, "};\n\n");
+    out_puts("unsigned int\n");
+    out_puts("_ltl2ba_stutter_class() {\n");
+    print_c_class_tree(0, 1);
+    out_puts("}\n\n");
 }
 
 void
 print_c_conclusion_function() {
 
-    fprintf(tl_out, "void\n");
-    fprintf(tl_out, "_ltl2ba_result() {\n");
+    out_puts("void\n");
+    out_puts("_ltl2ba_result() {\n");
 
-    fprintf(tl_out, "\t_Bool reject_sure = _ltl2ba_surely_reject[_ltl2ba_state_var];\n");
-    fprintf(tl_out, "\t%s(!reject_sure);\n\n", assume_str);
+    out_puts("\t_Bool reject_sure = _ltl2ba_surely_reject[_ltl2ba_state_var];\n");
+    out_putc('\t');
+    out_puts(assume_str);
+    out_puts("(!reject_sure);\n\n");
 
-    fprintf(tl_out, "\t_Bool accept_sure = _ltl2ba_surely_accept[_ltl2ba_state_var];\n");
-    fprintf(tl_out, "\t%s(!accept_sure, \"ERROR SURE\");\n\n", assert_str);
+    out_puts("\t_Bool accept_sure = _ltl2ba_surely_accept[_ltl2ba_state_var];\n");
+    out_putc('\t');
+    out_puts(assert_str);
+    out_puts("(!accept_sure, \"ERROR SURE\");\n\n");
 
-    fprintf(tl_out, "\tunsigned int id = _ltl2ba_sym_to_id();\n");
-    fprintf(tl_out,
-            "\t_Bool accept_stutter = _ltl2ba_stutter_accept[id * %i + _ltl2ba_state_var];\n",
-            n_ba_state);
+    out_puts("\tunsigned int id = _ltl2ba_stutter_class();\n");
+    out_puts("\t_Bool accept_stutter = _ltl2ba_stutter_accept[id * ");
+    out_putint(n_ba_state);
+    out_puts(" + _ltl2ba_state_var];\n");
 
-    fprintf(tl_out, "\t%s(!accept_stutter, \"ERROR MAYBE\");\n", assert_str);
+    out_putc('\t');
+    out_puts(assert_str);
+    out_puts("(!accept_stutter, \"ERROR MAYBE\");\n");
 
-    fprintf(tl_out, "\t%s(accept_stutter, \"VALID MAYBE\");\n", assert_str);
+    out_putc('\t');
+    out_puts(assert_str);
+    out_puts("(accept_stutter, \"VALID MAYBE\");\n");
 
-    fprintf(tl_out, "}\n\n");
+    out_puts("}\n\n");
 }
 
 void
 print_c_buchi() {
 
-    n_ba_state = count_ba_states();
-    stutter_acceptance_table = (_Bool *)tl_emalloc(n_ba_state * (1 << sym_id) * sizeof(_Bool));
-    stutter_acceptance();
+    build_stutter_tables();
 
-    fprintf(tl_out, "/* ");
+    out_puts("/* ");
     put_uform();
-    fprintf(tl_out, " */\n\n");
+    out_puts(" */\n\n");
 
     print_c_atomics_definition();
-    fprintf(tl_out, "\n");
+    out_putc('\n');
     print_c_states_definition();
 
     /* Declare and initialize the global variable that will maintain the state
@@ -415,28 +727,27 @@ print_c_buchi() {
     BState *s;
     for(s = bstates->prv; s != bstates; s = s->prv) {
         if (s->id == -1) {
-            fprintf(tl_out, "_ltl2ba_state _ltl2ba_state_var = _ltl2ba_state_0_%d;\n\n", s->final);
+            out_puts("_ltl2ba_state _ltl2ba_state_var = _ltl2ba_state_0_");
+            out_putint(s->final);
+            out_puts(";\n\n");
             break;
         }
     }
 
     print_c_transition_function();
 
-    /* TODO: Surely accepting states are currently built under the assumption
-       the automaton is in reduced form
-    */
-    print_c_surely_accept_state_table();
-
-    /* TODO: Surely rejecting states are currently built under the assumption
-       the automaton is in reduced form
-    */
-    print_c_surely_reject_state_table();
+    /* Tables indicating if from the current state, every word will be
+       accepted (resp. rejected) whatever the suffix */
+    print_c_state_table("surely_accept", surely_accept_table);
+    print_c_state_table("surely_reject", surely_reject_table);
 
-    /* TODO: Under the assumption there is no more than sizeof(int)*8 symbols */
     print_c_stutter_acceptance_table();
 
     /* Print the conclusion function */
-    print_c_sym_to_id_function();
+    print_c_class_function();
     print_c_conclusion_function();
+    out_flush();
+
+    free_stutter_acceptance();
 
 }
@@ -0,0 +1,244 @@
+/***** ltl2ba : check.c *****/
+
+/* This file contains the emptiness check of the generalized Buchi
+   automaton (options -e and -v). The automaton is explored on demand
+   (see lazy.c) by a depth first search which computes its strongly
+   connected components on the fly, as in Couvreur's algorithm: each
+   root of a component of the search stack keeps the acceptance
+   conditions met inside it, and the search stops as soon as one of
+   them meets all the acceptance conditions. A run reaching this
+   component and going around it is then printed as an example.
+   During the search, the 'incoming' field of a state holds its depth
+   first number, or -1 once its component is done.
+*/
+
+#include "ltl2ba.h"
+
+extern FILE *tl_out;
+extern struct rusage tr_debut, tr_fin;
+extern struct timeval t_diff;
+extern int tl_stats, tl_check, *final_set, node_size, lazy_gcount;
+
+typedef struct CDfs { /* search stack */
+  GState *gstate;
+  GTrans *trans; /* last transition taken */
+} CDfs;
+
+typedef struct CRoot { /* roots of the components of the search stack */
+  int num;
+  int *in;  /* acceptance conditions of the transition to the root */
+  int *acc; /* acceptance conditions met in the component */
+} CRoot;
+
+typedef struct CPath { /* breadth first search in a component */
+  GState *gstate;
+  GTrans *trans; /* transition leading to gstate */
+  int prv;
+} CPath;
+
+static CDfs *dfs;
+static CRoot *roots;
+static GState **live; /* states of the components not done yet */
+static int dfs_size, roots_size, live_size, stack_max, rank;
+int check_found; /* 1 if the last check found an accepting run */
+
+/********************************************************************\
+|*              Search of an accepting component                    *|
+\********************************************************************/
+
+static void *grow(void *a, int size, int old, int new)
+{ /* enlarges a stack */
+  void *b = tl_emalloc(new * size);
+  if(old) {
+    memcpy(b, a, old * size);
+    tfree(a);
+  }
+  return b;
+}
+
+static void push_cstate(GState *s, int *in)
+{
+  int i;
+  if(live_size == stack_max) { /* the stacks are never larger than 'live' */
+    i = 2 * (stack_max + 16);
+    dfs   = (CDfs *)grow(dfs, sizeof(CDfs), stack_max, i);
+    roots = (CRoot *)grow(roots, sizeof(CRoot), stack_max, i);
+    live  = (GState **)grow(live, sizeof(GState *), stack_max, i);
+    for(; stack_max < i; stack_max++) {
+      roots[stack_max].in  = new_set(0);
+      roots[stack_max].acc = new_set(0);
+    }
+  }
+  s->incoming = ++rank;
+  dfs[dfs_size].gstate = s;
+  dfs[dfs_size++].trans = lazy_gsucc(s);
+  roots[roots_size].num = rank;
+  if(in) copy_set(in, roots[roots_size].in, 0);
+  else clear_set(roots[roots_size].in, 0);
+  clear_set(roots[roots_size++].acc, 0);
+  live[live_size++] = s;
+}
+
+static int search_accepting(GState *init)
+{ /* returns 1 if an accepting component is reachable from init */
+  GState *s;
+  GTrans *t;
+  int *acc = new_set(0);
+
+  push_cstate(init, (int *)0);
+  while(dfs_size) {
+    s = dfs[dfs_size - 1].gstate;
+    t = dfs[dfs_size - 1].trans = dfs[dfs_size - 1].trans->nxt;
+    if(t != s->trans) {
+      if(!t->to->incoming) /* a new state */
+        push_cstate(t->to, t->final);
+      else if(t->to->incoming > 0) { /* merges the components of the cycle */
+        copy_set(t->final, acc, 0);
+        while(roots[roots_size - 1].num > t->to->incoming) {
+          roots_size--;
+          merge_sets(acc, roots[roots_size].acc, 0);
+          merge_sets(acc, roots[roots_size].in, 0);
+        }
+        merge_sets(roots[roots_size - 1].acc, acc, 0);
+        if(included_set(final_set, roots[roots_size - 1].acc, 0)) {
+          tfree(acc);
+          return 1;
+        }
+      }
+    }
+    else { /* all the transitions of s are done */
+      dfs_size--;
+      if(roots[roots_size - 1].num == s->incoming) { /* s is a root */
+        roots_size--;
+        do
+          live[--live_size]->incoming = -1;
+        while(live[live_size] != s);
+      }
+    }
+  }
+  tfree(acc);
+  return 0;
+}
+
+/********************************************************************\
+|*              Display of an accepting run                         *|
+\********************************************************************/
+
+static void print_ctrans(GTrans *t)
+{
+  out_puts("\t(");
+  spin_print_set(t->pos, t->neg);
+  out_puts(")\n");
+}
+
+static GState *print_cpath(GState *from, int *todo, GState *to, int *mark, int round)
+{ /* prints a shortest path of the component from 'from' to 'to', or to a
+     transition meeting one of the acceptance conditions of 'todo', which
+     are removed from 'todo' when they are met on the way */
+  CPath *q = (CPath *)tl_emalloc((live_size + 1) * sizeof(CPath));
+  int head, tail = 0, i, j, found = -1, min = roots[roots_size - 1].num;
+  GTrans *t, **path;
+  GState *s;
+
+  q[tail].gstate = from;
+  q[tail].trans = (GTrans *)0;
+  q[tail++].prv = -1;
+  mark[from->incoming - min] = round;
+  for(head = 0; head < tail && found < 0; head++) {
+    s = q[head].gstate;
+    for(t = s->trans->nxt; t != s->trans && found < 0; t = t->nxt) {
+      if(t->to->incoming < min) continue; /* not in the component */
+      if((todo && !empty_intersect_sets(t->final, todo, 0)) || t->to == to)
+        found = tail;
+      else if(mark[t->to->incoming - min] == round)
+        continue;
+      mark[t->to->incoming - min] = round;
+      q[tail].gstate = t->to;
+      q[tail].trans = t;
+      q[tail++].prv = head;
+    }
+  }
+
+  path = (GTrans **)tl_emalloc(tail * sizeof(GTrans *));
+  for(i = 0, j = found; j > 0; j = q[j].prv) /* goes back to 'from' */
+    path[i++] = q[j].trans;
+  while(i--) {
+    print_ctrans(path[i]);
+    if(todo)
+      for(j = 0; j < node_size; j++)
+        todo[j] &= ~path[i]->final[j];
+  }
+  s = q[found].gstate;
+  tfree(path);
+  tfree(q);
+  return s;
+}
+
+static void print_crun()
+{ /* prints a run to the last root of the search stack, and a cycle
+     from this root meeting all the acceptance conditions */
+  GState *root, *s;
+  int i, round = 0, *todo = dup_set(final_set, 0);
+  int *mark = (int *)tl_emalloc((rank + 1) * sizeof(int));
+
+  out_puts("prefix:\n");
+  for(i = 0; dfs[i].gstate->incoming != roots[roots_size - 1].num; i++)
+    print_ctrans(dfs[i].trans);
+  root = s = dfs[i].gstate;
+
+  out_puts("cycle:\n");
+  while(!empty_set(todo, 0)) /* meets the remaining acceptance conditions */
+    s = print_cpath(s, todo, (GState *)0, mark, ++round);
+  if(s != root || round == 0) /* goes back to the root */
+    print_cpath(s, (int *)0, root, mark, ++round);
+
+  tfree(mark);
+  tfree(todo);
+}
+
+/********************************************************************\
+|*              Main function of the check                          *|
+\********************************************************************/
+
+void check_generalized()
+{ /* looks for an accepting run of the generalized Buchi automaton */
+  GState **init;
+  int i, n, found = 0;
+
+  if(tl_stats) getrusage(RUSAGE_SELF, &tr_debut);
+
+  dfs_size = roots_size = live_size = stack_max = rank = 0;
+  init = lazy_ginit(&n);
+  for(i = 0; i < n && !found; i++)
+    if(!init[i]->incoming)
+      found = search_accepting(init[i]);
+
+  check_found = found;
+  if(tl_check == 1)
+    out_puts(found ? "satisfiable\n" : "unsatisfiable\n");
+  else if(tl_check == 4) /* see equiv.c */
+    out_puts(found ? "not included, counterexample:\n" : "included\n");
+  else
+    out_puts(found ? "not valid\n" : "valid\n");
+  if(found)
+    print_crun();
+  out_flush();
+
+  if(tl_stats) {
+    getrusage(RUSAGE_SELF, &tr_fin);
+    timeval_subtract (&t_diff, &tr_fin.ru_utime, &tr_debut.ru_utime);
+    fprintf(tl_out, "\nEmptiness check of the generalized Buchi automaton : %i.%06is",
+		t_diff.tv_sec, t_diff.tv_usec);
+    fprintf(tl_out, "\n%i states explored\n", lazy_gcount);
+  }
+
+  for(i = 0; i < stack_max; i++) {
+    tfree(roots[i].in);
+    tfree(roots[i].acc);
+  }
+  if(stack_max) {
+    tfree(dfs);
+    tfree(roots);
+    tfree(live);
+  }
+}
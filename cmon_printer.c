@@ -0,0 +1,215 @@
+
+/* This file contains the function required to print a Büchi
+   automaton as a table-driven C monitor (option -t cmon).
+   Instead of a switch with one branch per transition, the monitor
+   keeps the set of the current states of the automaton as a bitset,
+   and each step computes the next set from the valuation of the
+   atomic propositions :
+   - with few propositions, the next set of every state and every
+     valuation is precomputed in a table ;
+   - otherwise, the pos/neg guards of the transitions are packed in
+     bitmask tables, and a transition is enabled when its guard
+     meets the valuation, which costs a few AND per transition.
+*/
+
+#include "ltl2ba.h"
+
+extern int accept;
+extern BState *bstates;
+
+extern int sym_id, sym_size, mod;
+extern char** sym_table;
+
+extern void put_uform(void);
+extern _Bool is_transition_valid(BTrans *, int *);
+extern void print_c_atomics_definition(void);
+extern void print_c_valuation_function(void);
+
+/* Limits of the precomputed table of successors */
+#define CMON_TABLE_SYMS 8
+#define CMON_TABLE_SIZE (1 << 16)
+
+/* Print an array of unsigned int */
+void
+print_cmon_array(const char *name, unsigned int *a, int n) {
+    int i;
+
+    out_puts("static const unsigned int _ltl2ba_");
+    out_puts(name);
+    out_putc('[');
+    out_putint(n ? n : 1);
+    out_puts("] = {");
+    for (i = 0; i < n; i++) {
+        out_puts(i % 8 ? ", " : (i ? ",\n\t" : "\n\t"));
+        out_putuint(a[i]);
+        out_putc('u');
+    }
+    if (!n)
+        out_putc('0');
+    out_puts("\n};\n\n");
+}
+
+/* Print a buchi automaton as a table-driven C monitor */
+void
+print_cmon_buchi() {
+
+    BState *s;
+    BTrans *t;
+    int n_state = 0, n_trans = 0;
+    int state_words, table;
+    int i, k, n;
+    unsigned int *first, *dest, *pos, *neg, *init, *acc, *next;
+    int *val = (int *)tl_emalloc(sym_size * sizeof(int));
+
+    /* Give an id to every state and count the states and transitions */
+    for (s = bstates->prv; s != bstates; s = s->prv, n_state++) {
+        s->label = n_state;
+        for (t = s->trans->nxt; t != s->trans; t = t->nxt)
+            n_trans++;
+    }
+    state_words = n_state / 32 + 1;
+    table = sym_id <= CMON_TABLE_SYMS &&
+        n_state * (1 << sym_id) * state_words <= CMON_TABLE_SIZE;
+
+    /* Initial and accepting states, as bitsets */
+    init = (unsigned int *)tl_emalloc(state_words * sizeof(int));
+    acc = (unsigned int *)tl_emalloc(state_words * sizeof(int));
+    for (s = bstates->prv; s != bstates; s = s->prv) {
+        if (s->id == -1)
+            init[s->label / 32] |= 1u << s->label % 32;
+        /* s->id == 0 means s is an accepting well */
+        if (s->final == accept || s->id == 0)
+            acc[s->label / 32] |= 1u << s->label % 32;
+    }
+
+    out_puts("/* ");
+    put_uform();
+    out_puts(" */\n\n");
+
+    print_c_atomics_definition();
+    out_puts("#define _LTL2BA_STATES ");
+    out_putint(n_state ? n_state : 1);
+    out_puts("\n#define _LTL2BA_STATE_WORDS ");
+    out_putint(state_words);
+    out_puts("\n#define _LTL2BA_SYM_WORDS ");
+    out_putint(sym_size);
+    out_puts("\n\n");
+
+    print_cmon_array("init", init, state_words);
+    print_cmon_array("final", acc, state_words);
+
+    if (table) {
+        /* Successors of every state for every valuation */
+        n = n_state * (1 << sym_id) * state_words;
+        next = (unsigned int *)tl_emalloc((n ? n : 1) * sizeof(int));
+        for (s = bstates->prv; s != bstates; s = s->prv)
+            for (k = 0; k < (1 << sym_id); k++) {
+                val[0] = k;
+                for (t = s->trans->nxt; t != s->trans; t = t->nxt)
+                    if (is_transition_valid(t, val))
+                        next[(s->label * (1 << sym_id) + k) * state_words
+                             + t->to->label / 32] |= 1u << t->to->label % 32;
+            }
+        out_puts("/* next[(s * 2^k + v) * _LTL2BA_STATE_WORDS + w] : word w of the\n");
+        out_puts("   states reached from s with the valuation v */\n");
+        print_cmon_array("next", next, n);
+        tfree(next);
+    }
+    else {
+        /* Transitions of each state, as compressed rows */
+        first = (unsigned int *)tl_emalloc((n_state + 1) * sizeof(int));
+        dest = (unsigned int *)tl_emalloc((n_trans + 1) * sizeof(int));
+        pos = (unsigned int *)tl_emalloc((n_trans * sym_size + 1) * sizeof(int));
+        neg = (unsigned int *)tl_emalloc((n_trans * sym_size + 1) * sizeof(int));
+        n = 0;
+        for (s = bstates->prv; s != bstates; s = s->prv) {
+            first[s->label] = n;
+            for (t = s->trans->nxt; t != s->trans; t = t->nxt, n++) {
+                dest[n] = t->to->label;
+                for (i = 0; i < sym_size; i++) {
+                    pos[n * sym_size + i] = t->pos[i];
+                    neg[n * sym_size + i] = t->neg[i];
+                }
+            }
+        }
+        first[n_state] = n;
+        out_puts("/* transitions first[s] to first[s + 1] - 1 leave the state s */\n");
+        print_cmon_array("first", first, n_state + 1);
+        print_cmon_array("dest", dest, n_trans);
+        out_puts("/* propositions true (pos) and false (neg) on each transition */\n");
+        print_cmon_array("pos", pos, n_trans * sym_size);
+        print_cmon_array("neg", neg, n_trans * sym_size);
+        tfree(first);
+        tfree(dest);
+        tfree(pos);
+        tfree(neg);
+    }
+
+    /* Current states */
+    out_puts("unsigned int _ltl2ba_current[_LTL2BA_STATE_WORDS];\n\n");
+
+    out_puts("void\n_ltl2ba_reset() {\n");
+    out_puts("\tint w;\n");
+    out_puts("\tfor (w = 0; w < _LTL2BA_STATE_WORDS; w++)\n");
+    out_puts("\t\t_ltl2ba_current[w] = _ltl2ba_init[w];\n");
+    out_puts("}\n\n");
+
+    /* Valuation of the atomic propositions, packed as in the C printer */
+    print_c_valuation_function();
+
+    /* One step of the automaton */
+    out_puts("void\n_ltl2ba_step() {\n");
+    out_puts("\tunsigned int v[_LTL2BA_SYM_WORDS], next[_LTL2BA_STATE_WORDS];\n");
+    out_puts("\tint s, w;\n");
+    if (!table)
+        out_puts("\tunsigned int t, miss;\n");
+    out_puts("\t_ltl2ba_valuation(v);\n");
+    out_puts("\tfor (w = 0; w < _LTL2BA_STATE_WORDS; w++)\n");
+    out_puts("\t\tnext[w] = 0;\n");
+    out_puts("\tfor (s = 0; s < _LTL2BA_STATES; s++) {\n");
+    out_puts("\t\tif (!(_ltl2ba_current[s / 32] >> (s % 32) & 1))\n");
+    out_puts("\t\t\tcontinue;\n");
+    if (table) {
+        out_puts("\t\tfor (w = 0; w < _LTL2BA_STATE_WORDS; w++)\n");
+        out_puts("\t\t\tnext[w] |= _ltl2ba_next[(s * ");
+        out_putint(1 << sym_id);
+        out_puts(" + v[0]) * _LTL2BA_STATE_WORDS + w];\n");
+    }
+    else {
+        out_puts("\t\tfor (t = _ltl2ba_first[s]; t < _ltl2ba_first[s + 1]; t++) {\n");
+        out_puts("\t\t\tmiss = 0;\n");
+        out_puts("\t\t\tfor (w = 0; w < _LTL2BA_SYM_WORDS; w++)\n");
+        out_puts("\t\t\t\tmiss |= (_ltl2ba_pos[t * _LTL2BA_SYM_WORDS + w] & ~v[w]) |\n");
+        out_puts("\t\t\t\t\t(_ltl2ba_neg[t * _LTL2BA_SYM_WORDS + w] & v[w]);\n");
+        out_puts("\t\t\tif (!miss)\n");
+        out_puts("\t\t\t\tnext[_ltl2ba_dest[t] / 32] |= 1u << (_ltl2ba_dest[t] % 32);\n");
+        out_puts("\t\t}\n");
+    }
+    out_puts("\t}\n");
+    out_puts("\tfor (w = 0; w < _LTL2BA_STATE_WORDS; w++)\n");
+    out_puts("\t\t_ltl2ba_current[w] = next[w];\n");
+    out_puts("}\n\n");
+
+    /* Verdicts */
+    out_puts("/* No run of the automaton reads the word read so far */\n");
+    out_puts("_Bool\n_ltl2ba_rejected() {\n");
+    out_puts("\tint w;\n");
+    out_puts("\tfor (w = 0; w < _LTL2BA_STATE_WORDS; w++)\n");
+    out_puts("\t\tif (_ltl2ba_current[w])\n");
+    out_puts("\t\t\treturn 0;\n");
+    out_puts("\treturn 1;\n");
+    out_puts("}\n\n");
+    out_puts("/* A run of the automaton is in an accepting state */\n");
+    out_puts("_Bool\n_ltl2ba_accepting() {\n");
+    out_puts("\tint w;\n");
+    out_puts("\tfor (w = 0; w < _LTL2BA_STATE_WORDS; w++)\n");
+    out_puts("\t\tif (_ltl2ba_current[w] & _ltl2ba_final[w])\n");
+    out_puts("\t\t\treturn 1;\n");
+    out_puts("\treturn 0;\n");
+    out_puts("}\n");
+    out_flush();
+
+    tfree(init);
+    tfree(acc);
+    tfree(val);
+}
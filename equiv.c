@@ -0,0 +1,105 @@
+/***** ltl2ba : equiv.c *****/
+
+/* This file contains the comparison of the languages of pairs of
+   formulas (option -q). The file lists the pairs, one formula per line:
+
+     # comments begin with '#'
+     [] (p -> <> q)
+     [] (!p || <> q)
+
+     p U q
+     <> q
+
+   where the blank lines and the comments are ignored. For a pair (a, b),
+   the inclusion of the words of a in the ones of b is checked by looking
+   for a run of (a) && !(b): its alternating automaton is the product of
+   the ones of a and of !b, so the search of check.c explores the product
+   on demand and stops at its first accepting run, which is printed as a
+   lasso. Both inclusions are checked. Their reports are captured in
+   memory (see out.c), so that the verdict of the pair comes first.
+   Each inclusion is a translation of its own, in the same run of
+   ltl2ba: a and b are translated once per direction, and the table of
+   the propositions is built again for each one (see free_alternating).
+*/
+
+#include "ltl2ba.h"
+
+extern FILE *tl_out;
+extern char *tl_pairs;
+extern int check_found;
+extern void alldone(int);
+extern void tl_translate(char *);
+
+static int pair_line = 0;
+
+static int read_formula(FILE *f, char *buf, int size)
+{ /* reads the next formula of the file into buf; returns 0 at the end */
+  char *p;
+  int n;
+  while(fgets(buf, size, f)) {
+    pair_line++;
+    n = strlen(buf);
+    if(n == size - 1 && buf[n - 1] != '\n') {
+      printf("ltl2ba: %s, line %i: formula too long\n", tl_pairs, pair_line);
+      alldone(1);
+    }
+    for(p = buf; *p == ' ' || *p == '\t'; p++)
+      ;
+    if(*p == '#' || *p == '\n' || *p == '\r' || !*p)
+      continue;
+    while(n && (buf[n - 1] == '\n' || buf[n - 1] == '\r'))
+      buf[--n] = '\0';
+    return 1;
+  }
+  return 0;
+}
+
+static char *included(char *a, char *b, int *yes)
+{ /* returns the report of the check whether the words of a are words
+     of b, to be freed by free(); sets yes to 1 if so */
+  char f[4096];
+  out_capture();
+  out_puts(a);
+  out_puts("  ->  ");
+  out_puts(b);
+  out_puts(" : ");
+  sprintf(f, "(%s) && !(%s)", a, b);
+  tl_translate(f);
+  *yes = !check_found;
+  return out_release((int *)0);
+}
+
+void check_pairs()
+{ /* compares the formulas of the pairs of the file tl_pairs */
+  FILE *f;
+  char a[2000], b[2000], *rab, *rba;
+  int n = 0, ab, ba;
+
+  if(!(f = fopen(tl_pairs, "r"))) {
+    printf("ltl2ba: cannot open %s\n", tl_pairs);
+    alldone(1);
+  }
+  while(read_formula(f, a, 2000)) {
+    if(!read_formula(f, b, 2000)) {
+      printf("ltl2ba: %s: the last formula has no pair\n", tl_pairs);
+      alldone(1);
+    }
+    n++;
+    rab = included(a, b, &ab);
+    rba = included(b, a, &ba);
+    fprintf(tl_out, "%spair %i : ", n > 1 ? "\n" : "", n);
+    if(ab && ba)
+      fprintf(tl_out, "equivalent\n");
+    else if(ab)
+      fprintf(tl_out, "the first formula is stronger\n");
+    else if(ba)
+      fprintf(tl_out, "the second formula is stronger\n");
+    else
+      fprintf(tl_out, "incomparable\n");
+    fputs(rab, tl_out);
+    fputs(rba, tl_out);
+    free(rab);
+    free(rba);
+  }
+  fclose(f);
+}
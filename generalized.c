@@ -38,15 +38,21 @@ extern ATrans **transition;
 extern struct rusage tr_debut, tr_fin;
 extern struct timeval t_diff;
 extern int tl_verbose, tl_stats, tl_simp_diff, tl_simp_fly, tl_fjtofj,
-  tl_simp_scc, *final_set, node_id;
+  tl_simp_scc, tl_jobs, tl_gba, tl_type, *final_set, node_id, node_size, sym_size, mod;
 extern char **sym_table;
 
 GState *gstack, *gremoved, *gstates, **init;
-GScc *scc_stack;
+static GScc *scc_stack;
 int init_size = 0, gstate_id = 1, gstate_count = 0, gtrans_count = 0;
-int *fin, *final, rank, scc_id, scc_size, *bad_scc;
+int *final, scc_id, scc_size, *bad_scc;
+static GExp *gexp; /* memory used by the main thread to expand states */
+static int rank;
+static int scc_uptodate = 0; /* 1 if the scc data still describes 'gstates' */
 
 void print_generalized();
+void print_json_generalized();
+void print_hoa_generalized();
+void print_bin_generalized();
 
 /********************************************************************\
 |*        Simplification of the generalized Buchi automaton         *|
@@ -59,6 +65,19 @@ void free_gstate(GState *s) /* frees a state and its transitions */
   tfree(s);
 }
 
+GState *merged_gstate(GState *s)
+{ /* finds the state that replaces a removed state, or 0 if there is none */
+  GState *r = s, *nxt;
+  while(r && !r->trans) /* a removed state points to its replacement */
+    r = r->prv;
+  while(s != r) { /* path compression */
+    nxt = s->prv;
+    s->prv = r;
+    s = nxt;
+  }
+  return r;
+}
+
 GState *remove_gstate(GState *s, GState *s1) /* removes a state */
 {
   GState *prv = s->prv;
@@ -70,10 +89,7 @@ GState *remove_gstate(GState *s, GState *s1) /* removes a state */
   s->nodes_set = 0;
   s->nxt = gremoved->nxt;
   gremoved->nxt = s;
-  s->prv = s1;
-  for(s1 = gremoved->nxt; s1 != gremoved; s1 = s1->nxt)
-    if(s1->prv == s)
-      s1->prv = s->prv;
+  s->prv = s1; /* states merged into s are now merged into s1 */
   return prv;
 } 
 
@@ -112,41 +128,82 @@ int same_gtrans(GState *a, GTrans *s, GState *b, GTrans *t, int use_scc)
   return 1; /* same transitions up to acceptance conditions */
 }
 
+/* The transitions of each state are simplified independently, by
+   par_for with the option -j: the transitions removed from gpass[i] are
+   kept in gpass_removed[i], and given back to the pool by the main
+   thread once all the states are done. */
+
+static GState **gpass;
+static GTrans **gpass_removed;
+static int gpass_size = 0;
+
+static void simplify_gstate_trans(int i, void *arg)
+{
+  GState *s = gpass[i];
+  GTrans *t, *t1;
+
+  t = s->trans->nxt;
+  while(t != s->trans) { /* tries to remove t */
+    copy_gtrans(t, s->trans);
+    t1 = s->trans->nxt;
+    while ( !((t != t1) 
+        && (t1->to == t->to) 
+        && included_set(t1->pos, t->pos, 1) 
+        && included_set(t1->neg, t->neg, 1) 
+        && (included_set(t->final, t1->final, 0)  /* acceptance conditions of t are also in t1 or may be ignored */
+            || (tl_simp_scc && ((s->incoming != t->to->incoming) || in_set(bad_scc, s->incoming))))) )
+      t1 = t1->nxt;
+    if(t1 != s->trans) { /* remove transition t */
+      GTrans *free = t->nxt;
+      t->to = free->to;
+      copy_set(free->pos, t->pos, 1);
+      copy_set(free->neg, t->neg, 1);
+      copy_set(free->final, t->final, 0);
+      t->nxt = free->nxt;
+      if(free == s->trans) s->trans = t;
+      free->nxt = gpass_removed[i];
+      gpass_removed[i] = free;
+    }
+    else
+      t = t->nxt;
+  }
+}
+
 int simplify_gtrans() /* simplifies the transitions */
 {
-  int changed = 0;
+  int i, n = 0, changed = 0;
   GState *s;
-  GTrans *t, *t1;
+  GTrans *t;
 
   if(tl_stats) getrusage(RUSAGE_SELF, &tr_debut);
 
-  for(s = gstates->nxt; s != gstates; s = s->nxt) {
-    t = s->trans->nxt;
-    while(t != s->trans) { /* tries to remove t */
-      copy_gtrans(t, s->trans);
-      t1 = s->trans->nxt;
-      while ( !((t != t1) 
-          && (t1->to == t->to) 
-          && included_set(t1->pos, t->pos, 1) 
-          && included_set(t1->neg, t->neg, 1) 
-          && (included_set(t->final, t1->final, 0)  /* acceptance conditions of t are also in t1 or may be ignored */
-              || (tl_simp_scc && ((s->incoming != t->to->incoming) || in_set(bad_scc, s->incoming))))) )
-        t1 = t1->nxt;
-      if(t1 != s->trans) { /* remove transition t */
-        GTrans *free = t->nxt;
-        t->to = free->to;
-        copy_set(free->pos, t->pos, 1);
-        copy_set(free->neg, t->neg, 1);
-        copy_set(free->final, t->final, 0);
-        t->nxt = free->nxt;
-        if(free == s->trans) s->trans = t;
-        free_gtrans(free, 0, 0);
-        changed++;
-      }
-      else
-        t = t->nxt;
+  for(s = gstates->nxt; s != gstates; s = s->nxt)
+    n++;
+  if(n > gpass_size) {
+    if(gpass_size) {
+      tfree(gpass);
+      tfree(gpass_removed);
     }
+    gpass_size = 2 * n;
+    gpass = (GState **)tl_emalloc(gpass_size * sizeof(GState *));
+    gpass_removed = (GTrans **)tl_emalloc(gpass_size * sizeof(GTrans *));
+  }
+  for(i = 0, s = gstates->nxt; s != gstates; s = s->nxt, i++) {
+    gpass[i] = s;
+    gpass_removed[i] = (GTrans *)0;
   }
+
+  par_for(n, simplify_gstate_trans, (void *)0);
+
+  for(i = 0; i < n; i++)
+    while(gpass_removed[i]) {
+      t = gpass_removed[i];
+      gpass_removed[i] = t->nxt;
+      free_gtrans(t, 0, 0);
+      changed++;
+    }
+  /* the sccs are unchanged, but a new search may number them differently */
+  if(changed) scc_uptodate = 0;
   
   if(tl_stats) {
     getrusage(RUSAGE_SELF, &tr_fin);
@@ -166,11 +223,11 @@ void retarget_all_gtrans()
   int i;
   for (i = 0; i < init_size; i++)
     if (init[i] && !init[i]->trans) /* init[i] has been removed */
-      init[i] = init[i]->prv;
+      init[i] = merged_gstate(init[i]);
   for (s = gstates->nxt; s != gstates; s = s->nxt)
     for (t = s->trans->nxt; t != s->trans; )
       if (!t->to->trans) { /* t->to has been removed */
-	t->to = t->to->prv;
+	t->to = merged_gstate(t->to);
 	if(!t->to) { /* t->to has no transitions */
 	  GTrans *free = t->nxt;
 	  t->to = free->to;
@@ -231,6 +288,7 @@ int simplify_gstates() /* eliminates redundant states */
     b = a->nxt;
     while(!all_gtrans_match(a, b, tl_simp_scc)) b = b->nxt;
     if(b != gstates) { /* a and b are equivalent */
+      scc_uptodate = 0; /* retargeting the transitions may merge sccs */
       /* if scc(a)>scc(b) and scc(a) is non-trivial then all_gtrans_match(a,b,use_scc) must fail */
       if(a->incoming > b->incoming) /* scc(a) is trivial */
         a = remove_gstate(a, b);
@@ -254,44 +312,49 @@ int simplify_gstates() /* eliminates redundant states */
 
 int gdfs(GState *s) {
   GTrans *t;
-  GScc *c;
   GScc *scc = (GScc *)tl_emalloc(sizeof(GScc));
+  int theta;
   scc->gstate = s;
   scc->rank = rank;
   scc->theta = rank++;
   scc->nxt = scc_stack;
   scc_stack = scc;
 
-  s->incoming = 1;
+  s->incoming = -scc->rank; /* the state is on the stack */
 
   for (t = s->trans->nxt; t != s->trans; t = t->nxt) {
     if (t->to->incoming == 0) {
       int result = gdfs(t->to);
       scc->theta = min(scc->theta, result);
     }
-    else {
-      for(c = scc_stack->nxt; c != 0; c = c->nxt)
-	if(c->gstate == t->to) {
-	  scc->theta = min(scc->theta, c->rank);
-	  break;
-	}
-    }
+    else if (t->to->incoming < 0) /* on the stack: its rank is -incoming */
+      scc->theta = min(scc->theta, -t->to->incoming);
   }
+  theta = scc->theta;
   if(scc->rank == scc->theta) {
     while(scc_stack != scc) {
-      scc_stack->gstate->incoming = scc_id;
-      scc_stack = scc_stack->nxt;
+      GScc *c = scc_stack;
+      c->gstate->incoming = scc_id;
+      scc_stack = c->nxt;
+      tfree(c);
     }
     scc->gstate->incoming = scc_id++;
     scc_stack = scc->nxt;
+    tfree(scc);
   }
-  return scc->theta;
+  return theta;
 }
 
 void simplify_gscc() {
   GState *s;
   GTrans *t;
   int i, **scc_final;
+
+  /* removing states without transitions only shifts the scc numbers
+     of the other states: the scc data computed by the last call is then
+     still exact and need not be computed again */
+  if(scc_uptodate) return;
+
   rank = 1;
   scc_stack = 0;
   scc_id = 1;
@@ -318,6 +381,7 @@ void simplify_gscc() {
           merge_sets(scc_final[s->incoming], t->final, 0);
 
   scc_size = (scc_id + 1) / (8 * sizeof(int)) + 1;
+  if(bad_scc) tfree(bad_scc);
   bad_scc=make_set(-1,2);
 
   for(i = 0; i < scc_id; i++)
@@ -327,6 +391,7 @@ void simplify_gscc() {
   for(i = 0; i < scc_id; i++)
     tfree(scc_final[i]);
   tfree(scc_final);
+  scc_uptodate = 1;
 }
 
 /********************************************************************\
@@ -352,28 +417,358 @@ int is_final(int *from, ATrans *at, int i) /*is the transition final for i ?*/
   return 0;
 }
 
+/* The transitions of a state are computed by expand_gstate, which only
+   reads the alternating automaton: with the option -j, the states of the
+   stack are expanded in advance by other threads. The memory used there
+   comes from malloc, as tl_emalloc and the transition pools are not
+   thread safe. */
+
+GExp *new_gexp() /* allocates the memory used by expand_gstate */
+{
+  int i;
+  GExp *e = (GExp *)emalloc(sizeof(GExp));
+  ATrans *t;
+  e->list = (int *)emalloc((node_id + 1) * sizeof(int));
+  e->size = (int *)emalloc(node_id * sizeof(int));
+  e->cur  = (ATrans **)emalloc((node_id + 1) * sizeof(ATrans *));
+  e->to   = (int **)emalloc((node_id + 1) * sizeof(int *));
+  e->pos  = (int **)emalloc((node_id + 1) * sizeof(int *));
+  e->neg  = (int **)emalloc((node_id + 1) * sizeof(int *));
+  for(i = 0; i <= node_id; i++) {
+    e->to[i]  = (int *)emalloc(node_size * sizeof(int));
+    e->pos[i] = (int *)emalloc(sym_size * sizeof(int));
+    e->neg[i] = (int *)emalloc(sym_size * sizeof(int));
+  }
+  for(i = 0; i < node_id; i++)
+    for(e->size[i] = 0, t = transition[i]; t; t = t->nxt)
+      e->size[i]++;
+  e->memo = (struct GMemo **)0;
+  e->memo_size = e->memo_count = 0;
+  return e;
+}
+
+static void free_gmemo(GExp *);
+
+void free_gexp(GExp *e)
+{
+  int i;
+  free_gmemo(e);
+  for(i = 0; i <= node_id; i++) {
+    free(e->to[i]);
+    free(e->pos[i]);
+    free(e->neg[i]);
+  }
+  free(e->list);
+  free(e->size);
+  free(e->cur);
+  free(e->to);
+  free(e->pos);
+  free(e->neg);
+  free(e);
+}
+
+void free_gcands(GCand *c)
+{
+  GCand *nxt;
+  for(; c; c = nxt) {
+    nxt = c->nxt;
+    free(c);
+  }
+}
+
+static void merge_level(GExp *e, int i) /* computes the product up to the i-th node */
+{
+  do_merge_sets(e->to[i],  e->to[i-1],  e->cur[i]->to,  0);
+  do_merge_sets(e->pos[i], e->pos[i-1], e->cur[i]->pos, 1);
+  do_merge_sets(e->neg[i], e->neg[i-1], e->cur[i]->neg, 1);
+}
+
+/* The same products of transitions appear in the expansion of many
+   states, and is_final scans all the transitions of the node for each
+   of them. The result of the scan is kept in a table of the GExp, so
+   that each thread has its own. The table is emptied when it is full. */
+
+#define GMEMO_MAX 65536
+
+typedef struct GMemo { /* acceptance conditions known for a product */
+  int *to;
+  int *pos;
+  int *neg;
+  int *known; /* the nodes already checked by is_final */
+  int *dom;   /* those for which a transition of the node is included */
+  struct GMemo *nxt;
+} GMemo;
+
+static unsigned int hash_gmemo(int *to, int *pos, int *neg)
+{
+  int i;
+  unsigned int h = 2166136261u;
+  for(i = 0; i < node_size; i++)
+    h = (h ^ (unsigned int)to[i]) * 16777619u;
+  for(i = 0; i < sym_size; i++) {
+    h = (h ^ (unsigned int)pos[i]) * 16777619u;
+    h = (h ^ (unsigned int)neg[i]) * 16777619u;
+  }
+  return h;
+}
+
+static void free_gmemo(GExp *e)
+{
+  GMemo *m, *nxt;
+  int i;
+  for(i = 0; i < e->memo_size; i++)
+    for(m = e->memo[i]; m; m = nxt) {
+      nxt = m->nxt;
+      free(m);
+    }
+  if(e->memo_size) free(e->memo);
+  e->memo = (GMemo **)0;
+  e->memo_size = e->memo_count = 0;
+}
+
+static GMemo *get_gmemo(GExp *e, int *to, int *pos, int *neg)
+{ /* finds the entry of a product, or creates it */
+  GMemo *m, *nxt, **table;
+  int i, size;
+  if(e->memo_count >= GMEMO_MAX)
+    free_gmemo(e);
+  if(e->memo_size)
+    for(m = e->memo[hash_gmemo(to, pos, neg) % e->memo_size]; m; m = m->nxt)
+      if(same_sets(m->to, to, 0) && same_sets(m->pos, pos, 1) &&
+         same_sets(m->neg, neg, 1))
+        return m;
+
+  if(e->memo_count >= e->memo_size) { /* grows the table */
+    size = e->memo_size ? 2 * e->memo_size : 256;
+    table = (GMemo **)emalloc(size * sizeof(GMemo *));
+    for(i = 0; i < size; i++)
+      table[i] = (GMemo *)0;
+    for(i = 0; i < e->memo_size; i++)
+      for(m = e->memo[i]; m; m = nxt) {
+        nxt = m->nxt;
+        m->nxt = table[hash_gmemo(m->to, m->pos, m->neg) % size];
+        table[hash_gmemo(m->to, m->pos, m->neg) % size] = m;
+      }
+    if(e->memo_size) free(e->memo);
+    e->memo = table;
+    e->memo_size = size;
+  }
+
+  m = (GMemo *)emalloc(sizeof(GMemo) + (3 * node_size + 2 * sym_size) * sizeof(int));
+  m->to    = (int *)(m + 1);
+  m->known = m->to + node_size;
+  m->dom   = m->known + node_size;
+  m->pos   = m->dom + node_size;
+  m->neg   = m->pos + sym_size;
+  copy_set(to,  m->to,  0);
+  copy_set(pos, m->pos, 1);
+  copy_set(neg, m->neg, 1);
+  clear_set(m->known, 0);
+  clear_set(m->dom, 0);
+  m->nxt = e->memo[hash_gmemo(to, pos, neg) % e->memo_size];
+  e->memo[hash_gmemo(to, pos, neg) % e->memo_size] = m;
+  e->memo_count++;
+  return m;
+}
+
+static int memo_final(GExp *e, GCand *c, int *from, GMemo **p, int i)
+{ /* is_final, using the memo */
+  ATrans at;
+  GMemo *m;
+  if((tl_fjtofj && !in_set(c->to, i)) ||
+    (!tl_fjtofj && !in_set(from,  i))) return 1;
+  if(!*p) /* the product is searched only when a scan may be needed */
+    *p = get_gmemo(e, c->to, c->pos, c->neg);
+  m = *p;
+  if(!in_set(m->known, i)) {
+    at.to  = m->to;
+    at.pos = m->pos;
+    at.neg = m->neg;
+    add_set(m->known, i);
+    if(is_final(from, &at, i))
+      add_set(m->dom, i);
+  }
+  return in_set(m->dom, i);
+}
+
+static GCand *new_gcand(GExp *e, int k, int *from)
+{ /* copies the current product and computes its acceptance conditions */
+  int i;
+  GMemo *m = (GMemo *)0;
+  GCand *c = (GCand *)emalloc(sizeof(GCand) +
+                              2 * (node_size + sym_size) * sizeof(int));
+  c->to    = (int *)(c + 1);
+  c->final = c->to + node_size;
+  c->pos   = c->final + node_size;
+  c->neg   = c->pos + sym_size;
+  copy_set(e->to[k],  c->to,  0);
+  copy_set(e->pos[k], c->pos, 1);
+  copy_set(e->neg[k], c->neg, 1);
+  clear_set(c->final, 0);
+  for(i = 1; i < final[0]; i++)
+    if(memo_final(e, c, from, &m, final[i]))
+      add_set(c->final, final[i]);
+  return c;
+}
+
+GCand *expand_gstate(int *set, GExp *e)
+{ /* computes the transitions from a set of nodes of the alternating automaton:
+     the product of the transitions of the nodes, in lexicographic order */
+  int i, j, l, n, k = 0;
+  GCand *result = (GCand *)0, **last = &result;
+
+  for(i = 0; i < node_size; i++)
+    for(j = 0; j < mod; j++)
+      if(set[i] & (1 << j)) {
+        n = mod * i + j;
+        if(!transition[n])
+          return result; /* a node has no transitions */
+        /* the nodes having a single transition are expanded first, so
+           that the contradictions are found as high as possible; the
+           order of the other nodes, and so of the products, is kept */
+        for(l = ++k; l > 1 && e->size[n] == 1 && e->size[e->list[l - 1]] > 1; l--)
+          e->list[l] = e->list[l - 1];
+        e->list[l] = n;
+      }
+
+  clear_set(e->to[0],  0); /* the product of no transitions */
+  clear_set(e->pos[0], 1);
+  clear_set(e->neg[0], 1);
+  if(k == 0) {
+    *last = new_gcand(e, 0, set);
+    return result;
+  }
+
+  i = 1;
+  e->cur[1] = transition[e->list[1]];
+  while(i > 0) {
+    if(!e->cur[i]) { /* no more transitions for the i-th node */
+      if(--i > 0)
+        e->cur[i] = e->cur[i]->nxt;
+      continue;
+    }
+    merge_level(e, i);
+    if(empty_intersect_sets(e->pos[i], e->neg[i], 1)) {
+      if(i == k) { /* keeps the product */
+        *last = new_gcand(e, k, set);
+        last = &(*last)->nxt;
+      }
+      else { /* goes on with the next node */
+        i++;
+        e->cur[i] = transition[e->list[i]];
+        continue;
+      }
+    }
+    /* else no product of the next nodes can be kept */
+    e->cur[i] = e->cur[i]->nxt;
+  }
+  return result;
+}
+
+/* With the option -j, a job is created for each new state, and the
+   other threads expand the oldest states of the stack while the main
+   thread solves the newest ones (see parallel.c) */
+
+static void *expand_gjob(void *set, void *e) { return expand_gstate((int *)set, (GExp *)e); }
+static void *new_gjob_mem() { return new_gexp(); }
+static void free_gjob_mem(void *e) { free_gexp((GExp *)e); }
+static void free_gjob_result(void *c) { free_gcands((GCand *)c); }
+
+static void push_gjob(GState *s) /* asks the other threads to expand s */
+{
+  int *set = (int *)emalloc(node_size * sizeof(int));
+  copy_set(s->nodes_set, set, 0);
+  s->job = par_job_push(set);
+}
+
+/* The states created during the construction are indexed by their set
+   of nodes in 'gtable', which replaces the search in the stack, the
+   solved and the removed states. */
+
+typedef struct GCell {
+  GState *gstate;
+  struct GCell *nxt;
+} GCell;
+
+static GCell **gtable;
+static int gtable_size = 0, gtable_count = 0;
+
+static unsigned int hash_gset(int *set)
+{
+  int i;
+  unsigned int h = 2166136261u;
+  for(i = 0; i < node_size; i++)
+    h = (h ^ (unsigned int)set[i]) * 16777619u;
+  return h;
+}
+
+static GState *get_gtable(int *set)
+{
+  GCell *c;
+  if(!gtable_size) return (GState *)0;
+  for(c = gtable[hash_gset(set) % gtable_size]; c; c = c->nxt)
+    if(same_sets(set, c->gstate->nodes_set, 0))
+      return c->gstate;
+  return (GState *)0;
+}
+
+static void put_gtable(GState *s)
+{
+  GCell *c, *nxt;
+  int i;
+  if(gtable_count >= gtable_size) { /* grows the table */
+    int size = gtable_size ? 2 * gtable_size : 64;
+    GCell **table = (GCell **)tl_emalloc(size * sizeof(GCell *));
+    for(i = 0; i < gtable_size; i++)
+      for(c = gtable[i]; c; c = nxt) {
+        nxt = c->nxt;
+        c->nxt = table[hash_gset(c->gstate->nodes_set) % size];
+        table[hash_gset(c->gstate->nodes_set) % size] = c;
+      }
+    if(gtable_size) tfree(gtable);
+    gtable = table;
+    gtable_size = size;
+  }
+  c = (GCell *)tl_emalloc(sizeof(GCell));
+  c->gstate = s;
+  c->nxt = gtable[hash_gset(s->nodes_set) % gtable_size];
+  gtable[hash_gset(s->nodes_set) % gtable_size] = c;
+  gtable_count++;
+}
+
+static void del_gtable(GState *s)
+{
+  GCell **c, *free;
+  for(c = &gtable[hash_gset(s->nodes_set) % gtable_size]; *c; c = &(*c)->nxt)
+    if((*c)->gstate == s) {
+      free = *c;
+      *c = free->nxt;
+      tfree(free);
+      gtable_count--;
+      return;
+    }
+}
+
+static void free_gtable()
+{
+  GCell *c, *nxt;
+  int i;
+  for(i = 0; i < gtable_size; i++)
+    for(c = gtable[i]; c; c = nxt) {
+      nxt = c->nxt;
+      tfree(c);
+    }
+  if(gtable_size) tfree(gtable);
+  gtable_size = gtable_count = 0;
+}
+
 GState *find_gstate(int *set, GState *s) 
 { /* finds the corresponding state, or creates it */
 
   if(same_sets(set, s->nodes_set, 0)) return s; /* same state */
 
-  s = gstack->nxt; /* in the stack */
-  gstack->nodes_set = set;
-  while(!same_sets(set, s->nodes_set, 0))
-    s = s->nxt;
-  if(s != gstack) return s;
-
-  s = gstates->nxt; /* in the solved states */
-  gstates->nodes_set = set;
-  while(!same_sets(set, s->nodes_set, 0))
-    s = s->nxt;
-  if(s != gstates) return s;
-
-  s = gremoved->nxt; /* in the removed states */
-  gremoved->nodes_set = set;
-  while(!same_sets(set, s->nodes_set, 0))
-    s = s->nxt;
-  if(s != gremoved) return s;
+  s = get_gtable(set); /* in the stack, the solved or the removed states */
+  if(s) return s;
 
   s = (GState *)tl_emalloc(sizeof(GState)); /* creates a new state */
   s->id = (empty_set(set, 0)) ? 0 : gstate_id++;
@@ -383,111 +778,66 @@ GState *find_gstate(int *set, GState *s)
   s->trans->nxt = s->trans;
   s->nxt = gstack->nxt;
   gstack->nxt = s;
+  put_gtable(s);
+  if(tl_jobs > 1) push_gjob(s);
   return s;
 }
 
 void make_gtrans(GState *s) { /* creates all the transitions from a state */
-  int i, *list, state_trans = 0, trans_exist = 1;
+  int state_trans = 0;
   GState *s1;
-  GTrans *t;
-  ATrans *t1, *free;
-  AProd *prod = (AProd *)tl_emalloc(sizeof(AProd)); /* initialization */
-  prod->nxt = prod;
-  prod->prv = prod;
-  prod->prod = emalloc_atrans();
-  clear_set(prod->prod->to,  0);
-  clear_set(prod->prod->pos, 1);
-  clear_set(prod->prod->neg, 1);
-  prod->trans = prod->prod;
-  prod->trans->nxt = prod->prod;
-  list = list_set(s->nodes_set, 0);
-
-  for(i = 1; i < list[0]; i++) {
-    AProd *p = (AProd *)tl_emalloc(sizeof(AProd));
-    p->astate = list[i];
-    p->trans = transition[list[i]];
-    if(!p->trans) trans_exist = 0;
-    p->prod = merge_trans(prod->nxt->prod, p->trans);
-    p->nxt = prod->nxt;
-    p->prv = prod;
-    p->nxt->prv = p;
-    p->prv->nxt = p;
-  }
-
-  while(trans_exist) { /* calculates all the transitions */
-    AProd *p = prod->nxt;
-    t1 = p->prod;
-    if(t1) { /* solves the current transition */
-      GTrans *trans, *t2;
-      clear_set(fin, 0);
-      for(i = 1; i < final[0]; i++)
-	if(is_final(s->nodes_set, t1, final[i]))
-	  add_set(fin, final[i]);
-      for(t2 = s->trans->nxt; t2 != s->trans;) {
-	if(tl_simp_fly &&
-	   included_set(t1->to, t2->to->nodes_set, 0) &&
-	   included_set(t1->pos, t2->pos, 1) &&
-	   included_set(t1->neg, t2->neg, 1) &&
-	   same_sets(fin, t2->final, 0)) { /* t2 is redondant */
-	  GTrans *free = t2->nxt;
-	  t2->to->incoming--;
-	  t2->to = free->to;
-	  copy_set(free->pos, t2->pos, 1);
-	  copy_set(free->neg, t2->neg, 1);
-	  copy_set(free->final, t2->final, 0);
-	  t2->nxt   = free->nxt;
-	  if(free == s->trans) s->trans = t2;
-	  free_gtrans(free, 0, 0);
-	  state_trans--;
-	}
-	else if(tl_simp_fly &&
-		included_set(t2->to->nodes_set, t1->to, 0) &&
-		included_set(t2->pos, t1->pos, 1) &&
-		included_set(t2->neg, t1->neg, 1) &&
-		same_sets(t2->final, fin, 0)) {/* t1 is redondant */
-	  break;
-	}
-	else {
-	  t2 = t2->nxt;
-	}
+  GCand *t1, *cands;
+
+  if(s->job) {
+    cands = (GCand *)par_job_pop(s->job, gexp);
+    s->job = 0;
+  }
+  else
+    cands = expand_gstate(s->nodes_set, gexp);
+
+  for(t1 = cands; t1; t1 = t1->nxt) { /* solves the current transition */
+    GTrans *trans, *t2;
+    for(t2 = s->trans->nxt; t2 != s->trans;) {
+      if(tl_simp_fly &&
+         included_set(t1->to, t2->to->nodes_set, 0) &&
+         included_set(t1->pos, t2->pos, 1) &&
+         included_set(t1->neg, t2->neg, 1) &&
+         same_sets(t1->final, t2->final, 0)) { /* t2 is redondant */
+        GTrans *free = t2->nxt;
+        t2->to->incoming--;
+        t2->to = free->to;
+        copy_set(free->pos, t2->pos, 1);
+        copy_set(free->neg, t2->neg, 1);
+        copy_set(free->final, t2->final, 0);
+        t2->nxt   = free->nxt;
+        if(free == s->trans) s->trans = t2;
+        free_gtrans(free, 0, 0);
+        state_trans--;
+      }
+      else if(tl_simp_fly &&
+              included_set(t2->to->nodes_set, t1->to, 0) &&
+              included_set(t2->pos, t1->pos, 1) &&
+              included_set(t2->neg, t1->neg, 1) &&
+              same_sets(t2->final, t1->final, 0)) {/* t1 is redondant */
+        break;
       }
-      if(t2 == s->trans) { /* adds the transition */
-	trans = emalloc_gtrans();
-	trans->to = find_gstate(t1->to, s);
-	trans->to->incoming++;
-	copy_set(t1->pos, trans->pos, 1);
-	copy_set(t1->neg, trans->neg, 1);
-	copy_set(fin,   trans->final, 0);
-	trans->nxt = s->trans->nxt;
-	s->trans->nxt = trans;
-	state_trans++;
+      else {
+        t2 = t2->nxt;
       }
     }
-    if(!p->trans)
-      break;
-    while(!p->trans->nxt) /* calculates the next transition */
-      p = p->nxt;
-    if(p == prod)
-      break;
-    p->trans = p->trans->nxt;
-    do_merge_trans(&(p->prod), p->nxt->prod, p->trans);
-    p = p->prv;
-    while(p != prod) {
-      p->trans = transition[p->astate];
-      do_merge_trans(&(p->prod), p->nxt->prod, p->trans);
-      p = p->prv;
+    if(t2 == s->trans) { /* adds the transition */
+      trans = emalloc_gtrans();
+      trans->to = find_gstate(t1->to, s);
+      trans->to->incoming++;
+      copy_set(t1->pos, trans->pos, 1);
+      copy_set(t1->neg, trans->neg, 1);
+      copy_set(t1->final, trans->final, 0);
+      trans->nxt = s->trans->nxt;
+      s->trans->nxt = trans;
+      state_trans++;
     }
   }
-  
-  tfree(list); /* free memory */
-  while(prod->nxt != prod) {
-    AProd *p = prod->nxt;
-    prod->nxt = p->nxt;
-    free_atrans(p->prod, 0);
-    tfree(p);
-  }
-  free_atrans(prod->prod, 0);
-  tfree(prod);
+  free_gcands(cands);
 
   if(tl_simp_fly) {
     if(s->trans == s->trans->nxt) { /* s has no transitions */
@@ -496,9 +846,6 @@ void make_gtrans(GState *s) { /* creates all the transitions from a state */
       s->prv = (GState *)0;
       s->nxt = gremoved->nxt;
       gremoved->nxt = s;
-      for(s1 = gremoved->nxt; s1 != gremoved; s1 = s1->nxt)
-	if(s1->prv == s)
-	s1->prv = (GState *)0;
       return;
     }
     
@@ -512,9 +859,6 @@ void make_gtrans(GState *s) { /* creates all the transitions from a state */
       s->prv = s1;
       s->nxt = gremoved->nxt;
       gremoved->nxt = s;
-      for(s1 = gremoved->nxt; s1 != gremoved; s1 = s1->nxt)
-	if(s1->prv == s)
-	  s1->prv = s->prv;
       return;
     }
   }
@@ -538,28 +882,37 @@ void reverse_print_generalized(GState *s) /* dumps the generalized Buchi automat
 
   reverse_print_generalized(s->nxt); /* begins with the last state */
 
-  fprintf(tl_out, "state %i (", s->id);
+  out_puts("state ");
+  out_putint(s->id);
+  out_puts(" (");
   print_set(s->nodes_set, 0);
-  fprintf(tl_out, ") : %i\n", s->incoming);
+  out_puts(") : ");
+  out_putint(s->incoming);
+  out_putc('\n');
   for(t = s->trans->nxt; t != s->trans; t = t->nxt) {
     if (empty_set(t->pos, 1) && empty_set(t->neg, 1))
-      fprintf(tl_out, "1");
+      out_putc('1');
     print_set(t->pos, 1);
-    if (!empty_set(t->pos, 1) && !empty_set(t->neg, 1)) fprintf(tl_out, " & ");
+    if (!empty_set(t->pos, 1) && !empty_set(t->neg, 1)) out_puts(" & ");
     print_set(t->neg, 1);
-    fprintf(tl_out, " -> %i : ", t->to->id);
+    out_puts(" -> ");
+    out_putint(t->to->id);
+    out_puts(" : ");
     print_set(t->final, 0);
-    fprintf(tl_out, "\n");
+    out_putc('\n');
   }
 }
 
 void print_generalized() { /* prints intial states and calls 'reverse_print' */
   int i;
-  fprintf(tl_out, "init :\n");
+  out_puts("init :\n");
   for(i = 0; i < init_size; i++)
-    if(init[i])
-      fprintf(tl_out, "%i\n", init[i]->id);
+    if(init[i]) {
+      out_putint(init[i]->id);
+      out_putc('\n');
+    }
   reverse_print_generalized(gstates->nxt);
+  out_flush();
 }
 
 /********************************************************************\
@@ -574,8 +927,9 @@ void mk_generalized()
 
   if(tl_stats) getrusage(RUSAGE_SELF, &tr_debut);
 
-  fin = new_set(0);
+  gexp = new_gexp();
   bad_scc = 0; /* will be initialized in simplify_gscc */
+  scc_uptodate = 0; /* the scc data of a previous automaton is stale */
   final = list_set(final_set, 0);
 
   gstack        = (GState *)tl_emalloc(sizeof(GState)); /* sentinel */
@@ -595,6 +949,8 @@ void mk_generalized()
     s->trans->nxt = s->trans;
     s->nxt = gstack->nxt;
     gstack->nxt = s;
+    if(!get_gtable(s->nodes_set))
+      put_gtable(s);
     init_size++;
   }
 
@@ -603,16 +959,28 @@ void mk_generalized()
   for(s = gstack->nxt; s != gstack; s = s->nxt)
     init[init_size++] = s;
 
+  if(tl_jobs > 1) { /* starts the threads expanding the states in advance */
+    par_jobs_start(expand_gjob, new_gjob_mem, free_gjob_mem, free_gjob_result);
+    for(s = gstack->nxt; s != gstack; s = s->nxt)
+      push_gjob(s);
+  }
+
   while(gstack->nxt != gstack) { /* solves all states in the stack until it is empty */
     s = gstack->nxt;
     gstack->nxt = gstack->nxt->nxt;
     if(!s->incoming) {
+      if(s->job) par_job_drop(s->job);
+      del_gtable(s);
       free_gstate(s);
       continue;
     }
     make_gtrans(s);
   }
 
+  if(tl_jobs > 1) par_jobs_stop();
+  free_gexp(gexp);
+  free_gtable();
+
   retarget_all_gtrans();
 
   if(tl_stats) {
@@ -645,9 +1013,22 @@ void mk_generalized()
     }
     
     if(tl_verbose) {
+      if(tl_simp_scc) { /* prints the sccs numbered by a new search */
+        scc_uptodate = 0;
+        simplify_gscc();
+      }
       fprintf(tl_out, "\nGeneralized Buchi automaton after simplification\n");
       print_generalized();
     }
   }
+
+  if(tl_gba) { /* the generalized automaton is the output (option -g) */
+    if(tl_type == OT_JSON)
+      print_json_generalized();
+    else if(tl_type == OT_BIN)
+      print_bin_generalized();
+    else
+      print_hoa_generalized();
+  }
 }
   
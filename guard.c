@@ -0,0 +1,237 @@
+/***** ltl2ba : guard.c *****/
+
+/* This file contains a small BDD package over the atomic propositions,
+   used to print the guards of the transitions. The guards of the
+   transitions between two states are combined in a BDD, and printed
+   as an irredundant sum of products computed from the BDD by the
+   algorithm of Minato and Morreale, instead of the disjunction of the
+   guards as they are.
+   The variables are ordered by their index in sym_table. Nodes 0 and 1
+   are the constants; the other ones are kept unique by a hash table,
+   and the results of the operations are kept in a direct mapped cache.
+   The nodes live between guard_start and guard_stop; their tables are
+   allocated with emalloc, as they are too large for the pools of mem.c.
+*/
+
+#include "ltl2ba.h"
+
+extern int sym_id, sym_size, mod;
+extern char **sym_table;
+
+#define G_AND    0
+#define G_OR     1
+#define G_ANDNOT 2 /* a && !b */
+
+#define G_CACHE 4096
+
+typedef struct GNode {
+  int var; /* sym_id for the constants */
+  int lo;  /* the node when the variable is false */
+  int hi;  /* the node when the variable is true */
+  int nxt; /* next node in the same bucket */
+} GNode;
+
+typedef struct GCache {
+  int op, a, b, result;
+} GCache;
+
+static GNode *nodes;
+static int node_count, node_max, *bucket;
+static GCache *cache;
+static int **cover_pos, **cover_neg, cover_count, cover_max;
+
+/********************************************************************\
+|*              Nodes and operations                                *|
+\********************************************************************/
+
+static unsigned int hash_gnode(int var, int lo, int hi)
+{
+  return ((unsigned int)var * 12582917u + (unsigned int)lo * 4256249u +
+          (unsigned int)hi) & (node_max - 1);
+}
+
+static int gnode(int var, int lo, int hi) /* finds a node, or creates it */
+{
+  GNode *n;
+  int i, h;
+  if(lo == hi) return lo;
+  for(i = bucket[hash_gnode(var, lo, hi)]; i; i = nodes[i].nxt)
+    if(nodes[i].var == var && nodes[i].lo == lo && nodes[i].hi == hi)
+      return i;
+  if(node_count == node_max) { /* grows the table */
+    n = (GNode *)emalloc(2 * node_max * sizeof(GNode));
+    memcpy(n, nodes, node_max * sizeof(GNode));
+    free(nodes);
+    free(bucket);
+    nodes = n;
+    node_max *= 2;
+    bucket = (int *)emalloc(node_max * sizeof(int));
+    for(i = 2; i < node_count; i++) {
+      h = hash_gnode(nodes[i].var, nodes[i].lo, nodes[i].hi);
+      nodes[i].nxt = bucket[h];
+      bucket[h] = i;
+    }
+  }
+  h = hash_gnode(var, lo, hi);
+  nodes[node_count].var = var;
+  nodes[node_count].lo = lo;
+  nodes[node_count].hi = hi;
+  nodes[node_count].nxt = bucket[h];
+  bucket[h] = node_count;
+  return node_count++;
+}
+
+static int apply(int op, int a, int b)
+{
+  GCache *c;
+  int v, lo, hi;
+
+  if(a < 2 && b < 2) /* both are constants */
+    switch(op) {
+    case G_AND: return a & b;
+    case G_OR:  return a | b;
+    default:    return a & !b;
+    }
+  switch(op) { /* shortcuts */
+  case G_AND:
+    if(!a || !b) return 0;
+    if(a == 1 || a == b) return b;
+    if(b == 1) return a;
+    break;
+  case G_OR:
+    if(a == 1 || b == 1) return 1;
+    if(!a || a == b) return b;
+    if(!b) return a;
+    break;
+  default:
+    if(!a || b == 1 || a == b) return 0;
+    if(!b) return a;
+  }
+
+  c = &cache[((unsigned int)a * 31u + (unsigned int)b * 7u + op) % G_CACHE];
+  if(c->op == op && c->a == a && c->b == b)
+    return c->result;
+  v = min(nodes[a].var, nodes[b].var);
+  lo = apply(op, nodes[a].var == v ? nodes[a].lo : a,
+             nodes[b].var == v ? nodes[b].lo : b);
+  hi = apply(op, nodes[a].var == v ? nodes[a].hi : a,
+             nodes[b].var == v ? nodes[b].hi : b);
+  v = gnode(v, lo, hi);
+  c = &cache[((unsigned int)a * 31u + (unsigned int)b * 7u + op) % G_CACHE];
+  c->op = op;
+  c->a = a;
+  c->b = b;
+  c->result = v;
+  return v;
+}
+
+int guard_cube(int *pos, int *neg) /* the conjunction of the literals */
+{
+  int i, g = 1;
+  for(i = sym_id - 1; i >= 0; i--) {
+    if(in_set(pos, i) && in_set(neg, i)) return 0;
+    if(in_set(pos, i)) g = gnode(i, 0, g);
+    else if(in_set(neg, i)) g = gnode(i, g, 0);
+  }
+  return g;
+}
+
+int guard_or(int a, int b)
+{
+  return apply(G_OR, a, b);
+}
+
+/********************************************************************\
+|*              Irredundant sum of products                         *|
+\********************************************************************/
+
+static void add_cube(int *pos, int *neg)
+{
+  int **p, **n;
+  if(cover_count == cover_max) {
+    p = (int **)tl_emalloc(2 * (cover_max + 8) * sizeof(int *));
+    n = (int **)tl_emalloc(2 * (cover_max + 8) * sizeof(int *));
+    if(cover_max) {
+      memcpy(p, cover_pos, cover_max * sizeof(int *));
+      memcpy(n, cover_neg, cover_max * sizeof(int *));
+      tfree(cover_pos);
+      tfree(cover_neg);
+    }
+    cover_pos = p;
+    cover_neg = n;
+    cover_max = 2 * (cover_max + 8);
+  }
+  cover_pos[cover_count] = dup_set(pos, 1);
+  cover_neg[cover_count++] = dup_set(neg, 1);
+}
+
+static int isop(int l, int u, int *pos, int *neg)
+{ /* adds to the cover the cubes, extended by pos and neg, of an
+     irredundant sum of products f with l <= f <= u; returns f */
+  int v, l0, l1, u0, u1, r0, r1, rd;
+
+  if(!l) return 0;
+  if(u == 1) {
+    add_cube(pos, neg);
+    return 1;
+  }
+  v = min(nodes[l].var, nodes[u].var);
+  l0 = nodes[l].var == v ? nodes[l].lo : l;
+  l1 = nodes[l].var == v ? nodes[l].hi : l;
+  u0 = nodes[u].var == v ? nodes[u].lo : u;
+  u1 = nodes[u].var == v ? nodes[u].hi : u;
+
+  add_set(neg, v); /* cubes needing !v */
+  r0 = isop(apply(G_ANDNOT, l0, u1), u0, pos, neg);
+  rem_set(neg, v);
+  add_set(pos, v); /* cubes needing v */
+  r1 = isop(apply(G_ANDNOT, l1, u0), u1, pos, neg);
+  rem_set(pos, v);
+  rd = isop(apply(G_OR, apply(G_ANDNOT, l0, r0), apply(G_ANDNOT, l1, r1)),
+            apply(G_AND, u0, u1), pos, neg); /* cubes without v */
+  return apply(G_OR, gnode(v, r0, r1), rd);
+}
+
+void guard_print_spin(int g) /* prints g as a sum of products for spin */
+{
+  int i, *pos = new_set(1), *neg = new_set(1);
+  cover_count = 0;
+  isop(g, g, pos, neg);
+  if(!cover_count)
+    out_putc('0');
+  for(i = 0; i < cover_count; i++) {
+    if(i) out_puts(") || (");
+    spin_print_set(cover_pos[i], cover_neg[i]);
+    tfree(cover_pos[i]);
+    tfree(cover_neg[i]);
+  }
+  tfree(pos);
+  tfree(neg);
+}
+
+/********************************************************************\
+|*              Beginning and end                                   *|
+\********************************************************************/
+
+void guard_start()
+{
+  node_max = 1024;
+  nodes = (GNode *)emalloc(node_max * sizeof(GNode));
+  bucket = (int *)emalloc(node_max * sizeof(int));
+  cache = (GCache *)emalloc(G_CACHE * sizeof(GCache));
+  memset(cache, -1, G_CACHE * sizeof(GCache));
+  nodes[0].var = nodes[1].var = sym_id; /* the constants */
+  node_count = 2;
+  cover_count = cover_max = 0;
+}
+
+void guard_stop()
+{
+  free(nodes);
+  free(bucket);
+  free(cache);
+  if(cover_max) {
+    tfree(cover_pos);
+    tfree(cover_neg);
+  }
+}
@@ -0,0 +1,188 @@
+
+/* This file contains the functions required to print an automaton
+  in the Hanoi Omega-Automata format (HOA v1).
+  The Büchi automaton is printed with its acceptance condition on
+  the states: the accepting states belong to the set {0} of Inf(0).
+  The generalized Büchi automaton (option -g) is printed with its
+  acceptance conditions on the transitions: the transition sets
+  {i} of the condition Inf(i) are the ones meeting the i-th final
+  node of the alternating automaton.
+*/
+
+#include "ltl2ba.h"
+
+extern int accept;
+extern BState *bstates;
+extern GState *gstates, **init;
+extern int init_size, *final;
+
+extern int sym_id, sym_size, mod;
+extern char** sym_table;
+
+extern void put_uform_quoted(void);
+
+/* Print the label of a transition : its symbols are
+   the atomic propositions, numbered as in `sym_table` */
+void
+print_hoa_label(int *pos, int *neg) {
+
+  int i, j, first = 1;
+
+  out_putc('[');
+  for (i = 0; i < sym_size; i++) {
+    for (j = 0; j < mod; j++) {
+      if ((pos[i] | neg[i]) & (1 << j)) {
+        if (first)
+          first = 0;
+        else
+          out_putc('&');
+        if (neg[i] & (1 << j))
+          out_putc('!');
+        out_putint(mod * i + j);
+      }
+    }
+  }
+  if (first)
+    out_putc('t');
+  out_putc(']');
+}
+
+/* Print the header lines up to the initial states */
+void
+print_hoa_header(int nb_states) {
+
+  out_puts("HOA: v1\nname: ");
+  put_uform_quoted();
+  out_puts("\nStates: ");
+  out_putint(nb_states);
+  out_putc('\n');
+}
+
+/* Print the list of atomic propositions */
+void
+print_hoa_ap() {
+
+  int i;
+
+  out_puts("AP: ");
+  out_putint(sym_id);
+  for (i = 0; i < sym_id; i++) {
+    out_puts(" \"");
+    out_puts(sym_table[i]);
+    out_puts("\"");
+  }
+  out_putc('\n');
+}
+
+/* Print a buchi automaton in hoa format */
+void
+print_hoa_buchi() {
+
+  BState *s;
+  BTrans *t;
+  int nb_states = 0;
+  int init_id = 0;
+
+  /* Give an id to every state and count them */
+  for (s = bstates->prv; s != bstates; s = s->prv, nb_states++) {
+    if (s->id == -1)
+      init_id = nb_states;
+    s->label = nb_states;
+  }
+
+  /* An empty automaton is a single state without transitions */
+  print_hoa_header(nb_states ? nb_states : 1);
+  out_puts("Start: ");
+  out_putint(init_id);
+  out_putc('\n');
+  print_hoa_ap();
+  out_puts("acc-name: Buchi\nAcceptance: 1 Inf(0)\n");
+  out_puts("properties: trans-labels explicit-labels state-acc\n");
+
+  out_puts("--BODY--\n");
+  if (!nb_states)
+    out_puts("State: 0\n");
+  for (s = bstates->prv; s != bstates; s = s->prv) {
+    out_puts("State: ");
+    out_putint(s->label);
+    /* s->id == 0 means s is an accepting well */
+    out_puts(s->final == accept || s->id == 0 ? " {0}\n" : "\n");
+    for (t = s->trans->nxt; t != s->trans; t = t->nxt) {
+      print_hoa_label(t->pos, t->neg);
+      out_putc(' ');
+      out_putint(t->to->label);
+      out_putc('\n');
+    }
+  }
+  out_puts("--END--\n");
+  out_flush();
+}
+
+/* Print a generalized buchi automaton in hoa format */
+void
+print_hoa_generalized() {
+
+  GState *s;
+  GTrans *t;
+  int nb_states = 0;
+  int nb_acc = final[0] - 1;
+  int i, j, first;
+
+  /* Give an id to every state and count them */
+  for (s = gstates->prv; s != gstates; s = s->prv, nb_states++)
+    s->label = nb_states;
+
+  /* An empty automaton is a single state without transitions */
+  print_hoa_header(nb_states ? nb_states : 1);
+  if (!nb_states)
+    out_puts("Start: 0\n");
+  for (i = 0; i < init_size; i++) {
+    if (!init[i])
+      continue;
+    for (j = 0; j < i && init[j] != init[i]; j++)
+      ;
+    if (j == i) { /* not printed yet */
+      out_puts("Start: ");
+      out_putint(init[i]->label);
+      out_putc('\n');
+    }
+  }
+  print_hoa_ap();
+
+  out_puts("acc-name: generalized-Buchi ");
+  out_putint(nb_acc);
+  out_puts("\nAcceptance: ");
+  out_putint(nb_acc);
+  out_puts(nb_acc ? " " : " t");
+  for (i = 0; i < nb_acc; i++) {
+    out_puts(i ? "&Inf(" : "Inf(");
+    out_putint(i);
+    out_putc(')');
+  }
+  out_puts("\nproperties: trans-labels explicit-labels trans-acc\n");
+
+  out_puts("--BODY--\n");
+  if (!nb_states)
+    out_puts("State: 0\n");
+  for (s = gstates->prv; s != gstates; s = s->prv) {
+    out_puts("State: ");
+    out_putint(s->label);
+    out_putc('\n');
+    for (t = s->trans->nxt; t != s->trans; t = t->nxt) {
+      print_hoa_label(t->pos, t->neg);
+      out_putc(' ');
+      out_putint(t->to->label);
+      first = 1;
+      for (i = 1; i < final[0]; i++) {
+        if (in_set(t->final, final[i])) {
+          out_puts(first ? " {" : " ");
+          out_putint(i - 1);
+          first = 0;
+        }
+      }
+      out_puts(first ? "\n" : "}\n");
+    }
+  }
+  out_puts("--END--\n");
+  out_flush();
+}
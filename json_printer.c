@@ -1,6 +1,13 @@
 
 /* This file contains the function required to
   print a Büchi automaton in json.
+  With the option -g, the generalized Büchi automaton is printed
+  instead: its acceptance conditions are on the transitions.
+  The compact json (-t cjson) has the same fields, without any
+  indentation, and the symbols of the transitions are given by their
+  index in "symbols". The ndjson (-t ndjson) is the compact json with
+  the formula, on a single line: with -F, each formula of the file
+  gets its line (see ndjson_file in main.c).
 */
 
 #include "ltl2ba.h"
@@ -9,9 +16,16 @@ extern FILE* tl_out;
 
 extern int accept;
 extern BState *bstates;
+extern GState *gstates, **init;
+extern int init_size, *final;
 
 extern int sym_id, sym_size, mod;
 extern char** sym_table;
+extern int tl_json;
+
+extern void put_uform_quoted(void);
+void print_cjson_buchi();
+void print_cjson_generalized();
 
 /* Current level of indentation */
 static int c_indent = 0;
@@ -21,61 +35,63 @@ void
 print_indent() {
   int i;
   for (i = 0; i < c_indent; i++)
-    fprintf(tl_out, "\t");
+    out_putc('\t');
 }
 
-/* Print a transition in json */
+/* Print a list of symbols in json */
 void
-print_json_trans(BTrans *t) {
+print_json_syms(int *set) {
 
   int i, j, first;
 
-  print_indent();
-  fprintf(tl_out, "{\n");
-
-  c_indent++;
-  /* Transition destination */
-  print_indent();
-  fprintf(tl_out, "\"dest\": %d,\n", t->to->label);
-
-  /* List of positive predicate on the transition */
-  print_indent();
-  fprintf(tl_out, "\"pos\": [");
+  out_putc('[');
   first = 1;
   for(i = 0; i < sym_size; i++) {
     for(j = 0; j < mod; j++) {
-      if(t->pos[i] & (1 << j)) {
+      if(set[i] & (1 << j)) {
         if (first)
           first = 0;
         else
-          fprintf(tl_out, ", ");
+          out_puts(", ");
 
-        fprintf(tl_out, "\"%s\"", sym_table[mod * i + j]);
+        out_putc('"');
+        out_puts(sym_table[mod * i + j]);
+        out_putc('"');
       }
     }
   }
-  fprintf(tl_out, "],\n");
+  out_putc(']');
+}
+
+/* Print a transition in json */
+void
+print_json_trans(BTrans *t) {
+
+  print_indent();
+  out_puts("{\n");
+
+  c_indent++;
+  /* Transition destination */
+  print_indent();
+  out_puts("\"dest\": ");
+  out_putint(t->to->label);
+  out_puts(",\n");
+
+  /* List of positive predicate on the transition */
+  print_indent();
+  out_puts("\"pos\": ");
+  print_json_syms(t->pos);
+  out_puts(",\n");
 
   /* List of positive negative on the transition */
   print_indent();
-  fprintf(tl_out, "\"neg\": [");
-  first = 1;
-  for(i = 0; i < sym_size; i++) {
-    for(j = 0; j < mod; j++) {
-      if(t->neg[i] & (1 << j)) {
-        if (first)
-          first = 0;
-        else
-          fprintf(tl_out, ", ");
-        fprintf(tl_out, "\"%s\"", sym_table[mod * i + j]);
-      }
-    }
-  }
-  fprintf(tl_out, "]\n");
+  out_puts("\"neg\": ");
+  print_json_syms(t->neg);
+  out_putc('\n');
 
   c_indent--;
   print_indent();
-  fprintf(tl_out, "}");
+  out_putc('}');
 
 }
 
@@ -86,20 +102,24 @@ print_json_state(BState *s) {
   int is_final = (s->final == accept || s->id == 0);
 
   print_indent();
-  fprintf(tl_out, "{\n");
+  out_puts("{\n");
 
   c_indent++;
   /* State name */
   print_indent();
-  fprintf(tl_out, "\"label\": %d,\n", s->label);
+  out_puts("\"label\": ");
+  out_putint(s->label);
+  out_puts(",\n");
 
   /* Is the sate final */
   print_indent();
-  fprintf(tl_out, "\"final\": %s,\n", is_final ? "true" : "false");
+  out_puts("\"final\": ");
+  out_puts(is_final ? "true" : "false");
+  out_puts(",\n");
 
   /* List of state outgoing transitions */
   print_indent();
-  fprintf(tl_out, "\"trans\": [\n");
+  out_puts("\"trans\": [\n");
   c_indent++;
 
   int first = 1;
@@ -107,17 +127,17 @@ print_json_state(BState *s) {
     if (first)
       first = 0;
     else
-      fprintf(tl_out, ",\n");
+      out_puts(",\n");
     print_json_trans(t);
   }
 
-  fprintf(tl_out, "\n");
+  out_putc('\n');
   c_indent--;
   print_indent();
-  fprintf(tl_out, "]\n");
+  out_puts("]\n");
   c_indent--;
   print_indent();
-  fprintf(tl_out, "}");
+  out_putc('}');
 
 }
 
@@ -127,10 +147,15 @@ print_json_buchi() {
 
   BState *s;
   int nb_states = 0;
-  int init_id;
+  int init_id = -1; /* no initial state in an empty automaton */
   int i;
   int first;
 
+  if (tl_json) {
+    print_cjson_buchi();
+    return;
+  }
+
   /* Give an id to every state and count them */
   for (s = bstates->prv; s != bstates; s = s->prv, nb_states++) {
     if (s->id == -1)
@@ -139,37 +164,45 @@ print_json_buchi() {
   }
 
   print_indent();
-  fprintf(tl_out, "{\n");
+  out_puts("{\n");
 
   c_indent++;
   /* Print the number of states */
   print_indent();
-  fprintf(tl_out, "\"nb_state\": %d,\n", nb_states);
+  out_puts("\"nb_state\": ");
+  out_putint(nb_states);
+  out_puts(",\n");
 
   /* Print the number of symbols */
   print_indent();
-  fprintf(tl_out, "\"nb_sym\": %d,\n", sym_id);
+  out_puts("\"nb_sym\": ");
+  out_putint(sym_id);
+  out_puts(",\n");
 
   /* Print the list of symbols */
   print_indent();
-  fprintf(tl_out, "\"symbols\": [");
+  out_puts("\"symbols\": [");
   first = 1;
   for (i = 0; i < sym_id; i++) {
     if (first)
       first = 0;
     else
-      fprintf(tl_out, ", ");
-    fprintf(tl_out, "\"%s\"", sym_table[i]);
+      out_puts(", ");
+    out_putc('"');
+    out_puts(sym_table[i]);
+    out_putc('"');
   }
-  fprintf(tl_out, "],\n");
+  out_puts("],\n");
 
   /* Print the id of the initial state */
   print_indent();
-  fprintf(tl_out, "\"init_state\": %d,\n", init_id);
+  out_puts("\"init_state\": ");
+  out_putint(init_id);
+  out_puts(",\n");
 
   /* Print the list of states */
   print_indent();
-  fprintf(tl_out, "\"states\": [\n");
+  out_puts("\"states\": [\n");
 
   c_indent++;
   first = 1;
@@ -177,16 +210,346 @@ print_json_buchi() {
     if (first)
       first = 0;
     else
-      fprintf(tl_out, ",\n");
+      out_puts(",\n");
     print_json_state(s);
   }
 
-  fprintf(tl_out, "\n");
+  out_putc('\n');
   c_indent--;
   print_indent();
-  fprintf(tl_out, "]\n");
+  out_puts("]\n");
   c_indent--;
   print_indent();
-  fprintf(tl_out, "}\n");
+  out_puts("}\n");
+  out_flush();
+
+}
+
+/* Print a transition of the generalized automaton in json */
+void
+print_json_gtrans(GTrans *t) {
+
+  int i, first;
+
+  print_indent();
+  out_puts("{\n");
 
+  c_indent++;
+  /* Transition destination */
+  print_indent();
+  out_puts("\"dest\": ");
+  out_putint(t->to->label);
+  out_puts(",\n");
+
+  /* List of positive and negative predicates on the transition */
+  print_indent();
+  out_puts("\"pos\": ");
+  print_json_syms(t->pos);
+  out_puts(",\n");
+  print_indent();
+  out_puts("\"neg\": ");
+  print_json_syms(t->neg);
+  out_puts(",\n");
+
+  /* List of acceptance conditions met by the transition */
+  print_indent();
+  out_puts("\"acc\": [");
+  first = 1;
+  for (i = 1; i < final[0]; i++) {
+    if (in_set(t->final, final[i])) {
+      if (first)
+        first = 0;
+      else
+        out_puts(", ");
+      out_putint(i - 1);
+    }
+  }
+  out_puts("]\n");
+
+  c_indent--;
+  print_indent();
+  out_putc('}');
+
+}
+
+/* Print a generalized buchi automaton in json format */
+void
+print_json_generalized() {
+
+  GState *s;
+  GTrans *t;
+  int nb_states = 0;
+  int i, j;
+  int first;
+
+  if (tl_json) {
+    print_cjson_generalized();
+    return;
+  }
+
+  /* Give an id to every state and count them */
+  for (s = gstates->prv; s != gstates; s = s->prv, nb_states++)
+    s->label = nb_states;
+
+  print_indent();
+  out_puts("{\n");
+
+  c_indent++;
+  /* Print the number of states */
+  print_indent();
+  out_puts("\"nb_state\": ");
+  out_putint(nb_states);
+  out_puts(",\n");
+
+  /* Print the number of symbols */
+  print_indent();
+  out_puts("\"nb_sym\": ");
+  out_putint(sym_id);
+  out_puts(",\n");
+
+  /* Print the list of symbols */
+  print_indent();
+  out_puts("\"symbols\": [");
+  first = 1;
+  for (i = 0; i < sym_id; i++) {
+    if (first)
+      first = 0;
+    else
+      out_puts(", ");
+    out_putc('"');
+    out_puts(sym_table[i]);
+    out_putc('"');
+  }
+  out_puts("],\n");
+
+  /* Print the number of acceptance conditions */
+  print_indent();
+  out_puts("\"nb_acc\": ");
+  out_putint(final[0] - 1);
+  out_puts(",\n");
+
+  /* Print the ids of the initial states */
+  print_indent();
+  out_puts("\"init_states\": [");
+  first = 1;
+  for (i = 0; i < init_size; i++) {
+    if (!init[i])
+      continue;
+    for (j = 0; j < i && init[j] != init[i]; j++)
+      ;
+    if (j < i) /* already printed */
+      continue;
+    if (first)
+      first = 0;
+    else
+      out_puts(", ");
+    out_putint(init[i]->label);
+  }
+  out_puts("],\n");
+
+  /* Print the list of states */
+  print_indent();
+  out_puts("\"states\": [\n");
+
+  c_indent++;
+  first = 1;
+  for (s = gstates->prv; s != gstates; s = s->prv) {
+    int first_trans = 1;
+    if (first)
+      first = 0;
+    else
+      out_puts(",\n");
+    print_indent();
+    out_puts("{\n");
+    c_indent++;
+    print_indent();
+    out_puts("\"label\": ");
+    out_putint(s->label);
+    out_puts(",\n");
+    print_indent();
+    out_puts("\"trans\": [\n");
+    c_indent++;
+    for (t = s->trans->nxt; t != s->trans; t = t->nxt) {
+      if (first_trans)
+        first_trans = 0;
+      else
+        out_puts(",\n");
+      print_json_gtrans(t);
+    }
+    out_putc('\n');
+    c_indent--;
+    print_indent();
+    out_puts("]\n");
+    c_indent--;
+    print_indent();
+    out_putc('}');
+  }
+
+  out_putc('\n');
+  c_indent--;
+  print_indent();
+  out_puts("]\n");
+  c_indent--;
+  print_indent();
+  out_puts("}\n");
+  out_flush();
+
+}
+
+/* Print a list of symbols in compact json : their indices */
+void
+print_cjson_syms(int *set) {
+
+  int i, j, first = 1;
+
+  out_putc('[');
+  for (i = 0; i < sym_size; i++) {
+    for (j = 0; j < mod; j++) {
+      if (set[i] & (1 << j)) {
+        if (first)
+          first = 0;
+        else
+          out_putc(',');
+        out_putint(mod * i + j);
+      }
+    }
+  }
+  out_putc(']');
+}
+
+/* Print the fields shared by both automata in compact json */
+void
+print_cjson_header(int nb_states) {
+
+  int i;
+
+  out_putc('{');
+  if (tl_json == 2) {
+    out_puts("\"formula\":");
+    put_uform_quoted();
+    out_putc(',');
+  }
+  out_puts("\"nb_state\":");
+  out_putint(nb_states);
+  out_puts(",\"nb_sym\":");
+  out_putint(sym_id);
+  out_puts(",\"symbols\":[");
+  for (i = 0; i < sym_id; i++) {
+    if (i)
+      out_putc(',');
+    out_putc('"');
+    out_puts(sym_table[i]);
+    out_putc('"');
+  }
+  out_puts("],");
+}
+
+/* Print a buchi automaton in compact json */
+void
+print_cjson_buchi() {
+
+  BState *s;
+  BTrans *t;
+  int nb_states = 0;
+  int init_id = -1;
+
+  /* Give an id to every state and count them */
+  for (s = bstates->prv; s != bstates; s = s->prv, nb_states++) {
+    if (s->id == -1)
+      init_id = nb_states;
+    s->label = nb_states;
+  }
+
+  print_cjson_header(nb_states);
+  out_puts("\"init_state\":");
+  out_putint(init_id);
+  out_puts(",\"states\":[");
+  for (s = bstates->prv; s != bstates; s = s->prv) {
+    if (s != bstates->prv)
+      out_putc(',');
+    out_puts("{\"label\":");
+    out_putint(s->label);
+    out_puts(s->final == accept || s->id == 0 ?
+             ",\"final\":true,\"trans\":[" : ",\"final\":false,\"trans\":[");
+    for (t = s->trans->nxt; t != s->trans; t = t->nxt) {
+      if (t != s->trans->nxt)
+        out_putc(',');
+      out_puts("{\"dest\":");
+      out_putint(t->to->label);
+      out_puts(",\"pos\":");
+      print_cjson_syms(t->pos);
+      out_puts(",\"neg\":");
+      print_cjson_syms(t->neg);
+      out_putc('}');
+    }
+    out_puts("]}");
+  }
+  out_puts("]}\n");
+  out_flush();
+}
+
+/* Print a generalized buchi automaton in compact json */
+void
+print_cjson_generalized() {
+
+  GState *s;
+  GTrans *t;
+  int nb_states = 0;
+  int i, j, first;
+
+  /* Give an id to every state and count them */
+  for (s = gstates->prv; s != gstates; s = s->prv, nb_states++)
+    s->label = nb_states;
+
+  print_cjson_header(nb_states);
+  out_puts("\"nb_acc\":");
+  out_putint(final[0] - 1);
+  out_puts(",\"init_states\":[");
+  first = 1;
+  for (i = 0; i < init_size; i++) {
+    if (!init[i])
+      continue;
+    for (j = 0; j < i && init[j] != init[i]; j++)
+      ;
+    if (j < i) /* already printed */
+      continue;
+    if (first)
+      first = 0;
+    else
+      out_putc(',');
+    out_putint(init[i]->label);
+  }
+  out_puts("],\"states\":[");
+  for (s = gstates->prv; s != gstates; s = s->prv) {
+    if (s != gstates->prv)
+      out_putc(',');
+    out_puts("{\"label\":");
+    out_putint(s->label);
+    out_puts(",\"trans\":[");
+    for (t = s->trans->nxt; t != s->trans; t = t->nxt) {
+      if (t != s->trans->nxt)
+        out_putc(',');
+      out_puts("{\"dest\":");
+      out_putint(t->to->label);
+      out_puts(",\"pos\":");
+      print_cjson_syms(t->pos);
+      out_puts(",\"neg\":");
+      print_cjson_syms(t->neg);
+      out_puts(",\"acc\":[");
+      first = 1;
+      for (i = 1; i < final[0]; i++) {
+        if (in_set(t->final, final[i])) {
+          if (first)
+            first = 0;
+          else
+            out_putc(',');
+          out_putint(i - 1);
+        }
+      }
+      out_puts("]}");
+    }
+    out_puts("]}");
+  }
+  out_puts("]}\n");
+  out_flush();
 }
@@ -0,0 +1,401 @@
+/***** ltl2ba : kripke.c *****/
+
+/* This file contains the check of a Kripke structure against the
+   formula (option -k). The structure is read from a file such as:
+
+     # comments begin with '#'
+     init 0
+     0 { p q } 1 2
+     1 { } 0
+     2 { p } 2
+
+   where each line gives a state, the propositions true in it, and its
+   successors. The states are numbered from 0, 'init' lists the initial
+   states (0 if it is missing), and a state without successors loops on
+   itself. The propositions are those of the formula, the others are
+   ignored.
+   The formula is negated, and the product of the structure with the
+   Buchi automaton of its negation is explored on demand (see lazy.c) by
+   a nested depth first search. Only the states of the product are kept,
+   in a hash table: their transitions are computed again when needed.
+   A run of the structure violating the formula is printed as a lasso.
+*/
+
+#include "ltl2ba.h"
+
+extern FILE *tl_out;
+extern struct rusage tr_debut, tr_fin;
+extern struct timeval t_diff;
+extern int tl_stats, sym_id;
+extern char **sym_table, *tl_kripke;
+extern void alldone(int);
+
+typedef struct KState { /* state of the Kripke structure */
+  int *label;
+  int *succ;
+  int succ_count;
+  int defined;
+} KState;
+
+typedef struct PState { /* state of the product */
+  int kstate;
+  BState *bstate;
+  int flags;
+  struct PState *nxt;
+} PState;
+
+#define P_BLUE 1 /* visited by the first search */
+#define P_CYAN 2 /* in the stack of the first search */
+#define P_RED  4 /* visited by a second search */
+
+typedef struct PFrame { /* stack of a search */
+  PState *pstate;
+  BTrans *trans; /* current transition of the Buchi state */
+  int succ;      /* and current successor of the Kripke state */
+} PFrame;
+
+static KState *kstates;
+static int kstate_count, kstate_max, *kinit, kinit_count;
+static PState **ptable;
+static int ptable_size, ptable_count;
+static PFrame *blue, *red;
+static int blue_size, red_size, blue_max, red_max;
+
+/********************************************************************\
+|*              Reading of the Kripke structure                     *|
+\********************************************************************/
+
+static int kline = 1;
+
+static void kripke_error(char *s)
+{
+  printf("ltl2ba: %s, line %i: %s\n", tl_kripke, kline, s);
+  alldone(1);
+}
+
+static int *grow_ints(int *a, int old, int new)
+{
+  int *b = (int *)tl_emalloc(new * sizeof(int));
+  if(old) {
+    memcpy(b, a, old * sizeof(int));
+    tfree(a);
+  }
+  return b;
+}
+
+static int kripke_token(FILE *f, char *buf, int size)
+{ /* reads a word, '{', '}' or the end of a line into buf;
+     returns 0 at the end of the file */
+  int c, n = 0;
+  while((c = getc(f)) == ' ' || c == '\t' || c == '\r')
+    ;
+  if(c == '#') /* a comment */
+    while((c = getc(f)) != '\n' && c != EOF)
+      ;
+  if(c == EOF) return 0;
+  if(c == '\n' || c == '{' || c == '}') {
+    buf[0] = c;
+    buf[1] = '\0';
+    return 1;
+  }
+  do {
+    if(n == size - 1) kripke_error("word too long");
+    buf[n++] = c;
+  } while((c = getc(f)) != EOF && !strchr(" \t\r\n{}#", c));
+  if(c != EOF) ungetc(c, f);
+  buf[n] = '\0';
+  return 1;
+}
+
+static int kripke_state(char *buf)
+{ /* the state numbered buf, created if needed */
+  char *end;
+  long n = strtol(buf, &end, 10);
+  if(*end || end == buf || n < 0 || n > 1000000000)
+    kripke_error("bad state number");
+  while(n >= kstate_max) {
+    KState *k;
+    if((size_t)kstate_max + 16 > ((unsigned int)-1 >> 2) / sizeof(KState))
+      kripke_error("too many states"); /* the size would not fit in an int */
+    k = (KState *)emalloc(2 * (kstate_max + 16) * sizeof(KState));
+    if(kstate_max) {
+      memcpy(k, kstates, kstate_max * sizeof(KState));
+      free(kstates);
+    }
+    kstates = k;
+    kstate_max = 2 * (kstate_max + 16);
+  }
+  if(n >= kstate_count) kstate_count = n + 1;
+  return (int)n;
+}
+
+static void read_kripke()
+{
+  FILE *f;
+  char buf[256];
+  int i, s, *succ = (int *)0, succ_max = 0, init_max = 0, in_label;
+
+  if(!(f = fopen(tl_kripke, "r"))) {
+    printf("ltl2ba: cannot open %s\n", tl_kripke);
+    alldone(1);
+  }
+  kstate_count = kstate_max = kinit_count = 0;
+  kline = 1;
+  while(kripke_token(f, buf, 256)) {
+    if(buf[0] == '\n') { kline++; continue; }
+    if(!strcmp(buf, "init")) { /* initial states */
+      while(kripke_token(f, buf, 256) && buf[0] != '\n') {
+        if(kinit_count == init_max) {
+          kinit = grow_ints(kinit, init_max, 2 * (init_max + 4));
+          init_max = 2 * (init_max + 4);
+        }
+        kinit[kinit_count++] = kripke_state(buf);
+      }
+      kline++;
+      continue;
+    }
+    s = kripke_state(buf);
+    if(kstates[s].defined) kripke_error("state defined twice");
+    kstates[s].defined = 1;
+    kstates[s].label = new_set(1);
+    kstates[s].succ_count = 0;
+    in_label = 0;
+    while(kripke_token(f, buf, 256) && buf[0] != '\n') {
+      if(buf[0] == '{') {
+        if(in_label || kstates[s].succ_count) kripke_error("misplaced '{'");
+        in_label = 1;
+      }
+      else if(buf[0] == '}') {
+        if(in_label != 1) kripke_error("misplaced '}'");
+        in_label = 2;
+      }
+      else if(in_label == 1) { /* a proposition */
+        for(i = 0; i < sym_id; i++)
+          if(!strcmp(sym_table[i], buf)) add_set(kstates[s].label, i);
+      }
+      else { /* a successor */
+        if(kstates[s].succ_count == succ_max) {
+          succ = grow_ints(succ, succ_max, 2 * (succ_max + 16));
+          succ_max = 2 * (succ_max + 16);
+        }
+        succ[kstates[s].succ_count++] = kripke_state(buf);
+      }
+    }
+    if(in_label == 1) kripke_error("missing '}'");
+    if(!kstates[s].succ_count) { /* loops on itself */
+      kstates[s].succ = (int *)tl_emalloc(sizeof(int));
+      kstates[s].succ[kstates[s].succ_count++] = s;
+    }
+    else {
+      kstates[s].succ = (int *)tl_emalloc(kstates[s].succ_count * sizeof(int));
+      memcpy(kstates[s].succ, succ, kstates[s].succ_count * sizeof(int));
+    }
+    kline++;
+  }
+  fclose(f);
+  if(succ_max) tfree(succ);
+
+  if(!kstate_count) kripke_error("no state");
+  for(i = 0; i < kstate_count; i++)
+    if(!kstates[i].defined) {
+      sprintf(buf, "state %i is not defined", i);
+      kripke_error(buf);
+    }
+  if(!kinit_count) { /* the state 0 is initial */
+    kinit = grow_ints(kinit, 0, 1);
+    kinit[kinit_count++] = 0;
+  }
+}
+
+/********************************************************************\
+|*              States of the product                               *|
+\********************************************************************/
+
+static unsigned int hash_pstate(int k, BState *b)
+{
+  return (unsigned int)k * 16777619u + (unsigned int)b->label;
+}
+
+static PState *find_pstate(int k, BState *b) /* finds a state, or creates it */
+{
+  PState *p, *nxt, **table;
+  int i, size;
+  if(ptable_size)
+    for(p = ptable[hash_pstate(k, b) % ptable_size]; p; p = p->nxt)
+      if(p->kstate == k && p->bstate == b)
+        return p;
+  if(ptable_count >= ptable_size) { /* grows the table */
+    size = ptable_size ? 2 * ptable_size : 1024;
+    table = (PState **)tl_emalloc(size * sizeof(PState *));
+    for(i = 0; i < ptable_size; i++)
+      for(p = ptable[i]; p; p = nxt) {
+        nxt = p->nxt;
+        p->nxt = table[hash_pstate(p->kstate, p->bstate) % size];
+        table[hash_pstate(p->kstate, p->bstate) % size] = p;
+      }
+    if(ptable_size) tfree(ptable);
+    ptable = table;
+    ptable_size = size;
+  }
+  p = (PState *)tl_emalloc(sizeof(PState));
+  p->kstate = k;
+  p->bstate = b;
+  p->nxt = ptable[hash_pstate(k, b) % ptable_size];
+  ptable[hash_pstate(k, b) % ptable_size] = p;
+  ptable_count++;
+  return p;
+}
+
+static PFrame *push_pstate(PFrame *stack, int *size, int *max, PState *p)
+{
+  if(*size == *max) {
+    PFrame *s = (PFrame *)tl_emalloc(2 * (*max + 16) * sizeof(PFrame));
+    if(*max) {
+      memcpy(s, stack, *max * sizeof(PFrame));
+      tfree(stack);
+    }
+    stack = s;
+    *max = 2 * (*max + 16);
+  }
+  stack[*size].pstate = p;
+  stack[*size].trans = lazy_bsucc(p->bstate)->nxt;
+  stack[(*size)++].succ = 0;
+  return stack;
+}
+
+static PState *next_pstate(PFrame *f)
+{ /* the next successor of a state of the product, or 0 */
+  KState *k = &kstates[f->pstate->kstate];
+  BTrans *t = f->pstate->bstate->trans;
+  for(; f->trans != t; f->trans = f->trans->nxt, f->succ = 0)
+    if(included_set(f->trans->pos, k->label, 1) &&
+       empty_intersect_sets(f->trans->neg, k->label, 1) &&
+       f->succ < k->succ_count)
+      return find_pstate(k->succ[f->succ++], f->trans->to);
+  return (PState *)0;
+}
+
+/********************************************************************\
+|*              Nested depth first search                           *|
+\********************************************************************/
+
+static PState *red_search(PState *seed)
+{ /* looks for a cycle from seed to a state of the first stack */
+  PState *p;
+  red_size = 0;
+  seed->flags |= P_RED;
+  red = push_pstate(red, &red_size, &red_max, seed);
+  while(red_size) {
+    if((p = next_pstate(&red[red_size - 1]))) {
+      if(p->flags & P_CYAN)
+        return p;
+      if(!(p->flags & P_RED)) {
+        p->flags |= P_RED;
+        red = push_pstate(red, &red_size, &red_max, p);
+      }
+    }
+    else
+      red_size--;
+  }
+  return (PState *)0;
+}
+
+static PState *blue_search(PState *init)
+{ /* returns the state closing an accepting cycle, or 0 */
+  PState *p, *q;
+  init->flags |= P_BLUE | P_CYAN;
+  blue = push_pstate(blue, &blue_size, &blue_max, init);
+  while(blue_size) {
+    if((p = next_pstate(&blue[blue_size - 1]))) {
+      if(!(p->flags & P_BLUE)) {
+        p->flags |= P_BLUE | P_CYAN;
+        blue = push_pstate(blue, &blue_size, &blue_max, p);
+      }
+    }
+    else { /* all the successors are done */
+      p = blue[blue_size - 1].pstate;
+      if(lazy_baccept(p->bstate) && (q = red_search(p)))
+        return q;
+      p->flags &= ~P_CYAN;
+      blue_size--;
+    }
+  }
+  return (PState *)0;
+}
+
+static void print_kstate(int k)
+{
+  out_putc('\t');
+  out_putint(k);
+  out_puts(" {");
+  if(!empty_set(kstates[k].label, 1)) {
+    out_putc(' ');
+    print_set(kstates[k].label, 1);
+  }
+  out_puts(" }\n");
+}
+
+static void print_lasso(PState *q)
+{ /* the first stack up to q, then the cycle through the seed back to q */
+  int i;
+  out_puts("prefix:\n");
+  for(i = 0; blue[i].pstate != q; i++)
+    print_kstate(blue[i].pstate->kstate);
+  out_puts("cycle:\n");
+  for(; i < blue_size; i++)
+    print_kstate(blue[i].pstate->kstate);
+  for(i = 1; i < red_size; i++)
+    print_kstate(red[i].pstate->kstate);
+  out_flush();
+}
+
+/********************************************************************\
+|*              Main function of the check                          *|
+\********************************************************************/
+
+void check_kripke()
+{ /* checks the Kripke structure against the negation of the formula */
+  PState *p, *q = (PState *)0, *nxt;
+  int i;
+
+  read_kripke();
+  if(tl_stats) getrusage(RUSAGE_SELF, &tr_debut);
+
+  ptable_size = ptable_count = blue_size = blue_max = red_size = red_max = 0;
+  for(i = 0; i < kinit_count && !q; i++) {
+    p = find_pstate(kinit[i], lazy_binit());
+    if(!(p->flags & P_BLUE))
+      q = blue_search(p);
+  }
+
+  if(q) {
+    fprintf(tl_out, "the model does not satisfy the formula\n");
+    print_lasso(q);
+  }
+  else
+    fprintf(tl_out, "the model satisfies the formula\n");
+
+  if(tl_stats) {
+    getrusage(RUSAGE_SELF, &tr_fin);
+    timeval_subtract (&t_diff, &tr_fin.ru_utime, &tr_debut.ru_utime);
+    fprintf(tl_out, "\nNested search of the product : %i.%06is",
+		t_diff.tv_sec, t_diff.tv_usec);
+    fprintf(tl_out, "\n%i states of the product, %i states of the model\n",
+            ptable_count, kstate_count);
+  }
+
+  for(i = 0; i < ptable_size; i++)
+    for(p = ptable[i]; p; p = nxt) {
+      nxt = p->nxt;
+      tfree(p);
+    }
+  if(ptable_size) tfree(ptable);
+  if(blue_max) tfree(blue);
+  if(red_max) tfree(red);
+  for(i = 0; i < kstate_count; i++) {
+    tfree(kstates[i].label);
+    tfree(kstates[i].succ);
+  }
+  free(kstates);
+  tfree(kinit);
+}
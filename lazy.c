@@ -0,0 +1,313 @@
+/***** ltl2ba : lazy.c *****/
+
+/* This file gives access to the generalized Buchi automaton and to the
+   Buchi automaton of the formula without building them first: a state
+   is created when it is reached, and its transitions are computed from
+   the alternating automaton the first time they are asked for, with
+   the on the fly simplification of make_gtrans and make_btrans.
+   The states are kept in hash tables, and never merged nor removed, so
+   the automata may have more states than the printed ones, but they
+   accept the same words.
+   When tl_lazy is set, trans calls it instead of building the automata,
+   and tl_lazy explores them with:
+     lazy_ginit(&n)   the n initial states of the generalized automaton
+     lazy_gsucc(s)    the sentinel of the transitions of a generalized state
+     lazy_binit()     the initial state of the Buchi automaton
+     lazy_bsucc(s)    the sentinel of the transitions of a Buchi state
+     lazy_baccept(s)  1 if the Buchi state is accepting
+   Before it is explored, a state has no transitions (trans == 0).
+*/
+
+#include "ltl2ba.h"
+
+/********************************************************************\
+|*              Structures and shared variables                     *|
+\********************************************************************/
+
+extern ATrans **transition;
+extern int tl_simp_fly, *final_set, *final, accept, node_size, gstate_id;
+extern int next_final(int *, int);
+
+void (*tl_lazy)(void) = 0; /* explores the automata on demand */
+int lazy_gcount, lazy_bcount; /* number of states created */
+
+typedef struct LCell {
+  void *state;
+  unsigned int hash;
+  struct LCell *nxt;
+} LCell;
+
+typedef struct LTable {
+  LCell **cells;
+  int size, count;
+} LTable;
+
+static LTable gtable, btable;
+static GState **ginit;
+static int ginit_size;
+static BState *binit;
+static GExp *gexp;
+
+/********************************************************************\
+|*              Hash tables of the states                           *|
+\********************************************************************/
+
+static unsigned int hash_lgstate(int *set)
+{
+  int i;
+  unsigned int h = 2166136261u;
+  for(i = 0; i < node_size; i++)
+    h = (h ^ (unsigned int)set[i]) * 16777619u;
+  return h;
+}
+
+static unsigned int hash_lbstate(GState *gstate, int final)
+{
+  return (unsigned int)gstate->id * 31 + final;
+}
+
+static void put_ltable(LTable *t, void *state, unsigned int hash)
+{
+  LCell *c, *nxt, **cells;
+  int i, size;
+  if(t->count >= t->size) { /* grows the table */
+    size = t->size ? 2 * t->size : 256;
+    cells = (LCell **)tl_emalloc(size * sizeof(LCell *));
+    for(i = 0; i < t->size; i++)
+      for(c = t->cells[i]; c; c = nxt) {
+        nxt = c->nxt;
+        c->nxt = cells[c->hash % size];
+        cells[c->hash % size] = c;
+      }
+    if(t->size) tfree(t->cells);
+    t->cells = cells;
+    t->size = size;
+  }
+  c = (LCell *)tl_emalloc(sizeof(LCell));
+  c->state = state;
+  c->hash = hash;
+  c->nxt = t->cells[hash % t->size];
+  t->cells[hash % t->size] = c;
+  t->count++;
+}
+
+static GState *find_lgstate(int *set) /* finds a state, or creates it */
+{
+  unsigned int hash = hash_lgstate(set);
+  GState *s;
+  LCell *c;
+  if(gtable.size)
+    for(c = gtable.cells[hash % gtable.size]; c; c = c->nxt)
+      if(c->hash == hash && same_sets(((GState *)c->state)->nodes_set, set, 0))
+        return (GState *)c->state;
+  s = (GState *)tl_emalloc(sizeof(GState));
+  s->id = (empty_set(set, 0)) ? 0 : gstate_id++;
+  s->nodes_set = dup_set(set, 0);
+  s->trans = (GTrans *)0;
+  put_ltable(&gtable, s, hash);
+  lazy_gcount++;
+  return s;
+}
+
+static BState *find_lbstate(GState *gstate, int final)
+{ /* finds a state, or creates it */
+  unsigned int hash = hash_lbstate(gstate, final);
+  BState *s;
+  LCell *c;
+  if(btable.size)
+    for(c = btable.cells[hash % btable.size]; c; c = c->nxt)
+      if(((BState *)c->state)->gstate == gstate &&
+         ((BState *)c->state)->final == final)
+        return (BState *)c->state;
+  s = (BState *)tl_emalloc(sizeof(BState));
+  s->gstate = gstate;
+  s->id = gstate->id;
+  s->final = final;
+  s->trans = (BTrans *)0;
+  s->label = ++lazy_bcount; /* unique number of the state */
+  put_ltable(&btable, s, hash);
+  return s;
+}
+
+/********************************************************************\
+|*              Exploration of the automata                         *|
+\********************************************************************/
+
+GState **lazy_ginit(int *n) /* the initial states of the generalized automaton */
+{
+  *n = ginit_size;
+  return ginit;
+}
+
+GTrans *lazy_gsucc(GState *s) /* computes the transitions of s, if needed */
+{
+  GCand *c, *cands;
+  GTrans *t, *free;
+
+  if(s->trans) return s->trans;
+  s->trans = emalloc_gtrans(); /* sentinel */
+  s->trans->nxt = s->trans;
+
+  cands = expand_gstate(s->nodes_set, gexp);
+  for(c = cands; c; c = c->nxt) { /* as in make_gtrans */
+    for(t = s->trans->nxt; t != s->trans;) {
+      if(tl_simp_fly &&
+         included_set(c->to, t->to->nodes_set, 0) &&
+         included_set(c->pos, t->pos, 1) &&
+         included_set(c->neg, t->neg, 1) &&
+         same_sets(c->final, t->final, 0)) { /* t is redondant */
+        free = t->nxt;
+        t->to = free->to;
+        copy_set(free->pos, t->pos, 1);
+        copy_set(free->neg, t->neg, 1);
+        copy_set(free->final, t->final, 0);
+        t->nxt = free->nxt;
+        if(free == s->trans) s->trans = t;
+        free_gtrans(free, 0, 0);
+      }
+      else if(tl_simp_fly &&
+              included_set(t->to->nodes_set, c->to, 0) &&
+              included_set(t->pos, c->pos, 1) &&
+              included_set(t->neg, c->neg, 1) &&
+              same_sets(t->final, c->final, 0)) /* c is redondant */
+        break;
+      else
+        t = t->nxt;
+    }
+    if(t == s->trans) { /* adds the transition */
+      t = emalloc_gtrans();
+      t->to = find_lgstate(c->to);
+      copy_set(c->pos, t->pos, 1);
+      copy_set(c->neg, t->neg, 1);
+      copy_set(c->final, t->final, 0);
+      t->nxt = s->trans->nxt;
+      s->trans->nxt = t;
+    }
+  }
+  free_gcands(cands);
+  return s->trans;
+}
+
+BState *lazy_binit() /* the initial state of the Buchi automaton */
+{
+  return binit;
+}
+
+int lazy_baccept(BState *s) /* is s accepting ? */
+{
+  return s->gstate && s->final == accept;
+}
+
+static void add_lbtrans(BState *s, GTrans *g, int fin)
+{ /* adds a transition built from g, as in make_btrans */
+  BState *to = find_lbstate(g->to, fin);
+  BTrans *t, *free;
+  for(t = s->trans->nxt; t != s->trans;) {
+    if(tl_simp_fly &&
+       (to == t->to) &&
+       included_set(g->pos, t->pos, 1) &&
+       included_set(g->neg, t->neg, 1)) { /* t is redondant */
+      free = t->nxt;
+      t->to = free->to;
+      copy_set(free->pos, t->pos, 1);
+      copy_set(free->neg, t->neg, 1);
+      t->nxt = free->nxt;
+      if(free == s->trans) s->trans = t;
+      free_btrans(free, 0, 0);
+    }
+    else if(tl_simp_fly &&
+            (t->to == to) &&
+            included_set(t->pos, g->pos, 1) &&
+            included_set(t->neg, g->neg, 1)) /* g is redondant */
+      return;
+    else
+      t = t->nxt;
+  }
+  t = emalloc_btrans();
+  t->to = to;
+  copy_set(g->pos, t->pos, 1);
+  copy_set(g->neg, t->neg, 1);
+  t->nxt = s->trans->nxt;
+  s->trans->nxt = t;
+}
+
+BTrans *lazy_bsucc(BState *s) /* computes the transitions of s, if needed */
+{
+  GTrans *t;
+  int i;
+
+  if(s->trans) return s->trans;
+  s->trans = emalloc_btrans(); /* sentinel */
+  s->trans->nxt = s->trans;
+
+  if(!s->gstate) { /* the initial state */
+    for(i = 0; i < ginit_size; i++)
+      for(t = lazy_gsucc(ginit[i])->nxt; t != ginit[i]->trans; t = t->nxt)
+        add_lbtrans(s, t, next_final(t->final, 0));
+  }
+  else
+    for(t = lazy_gsucc(s->gstate)->nxt; t != s->gstate->trans; t = t->nxt)
+      add_lbtrans(s, t, next_final(t->final, (s->final == accept) ? 0 : s->final));
+  return s->trans;
+}
+
+/********************************************************************\
+|*              Beginning and end of the exploration                *|
+\********************************************************************/
+
+void lazy_start() /* prepares the exploration of the alternating automaton */
+{
+  ATrans *t;
+  int i;
+
+  gexp = new_gexp();
+  final = list_set(final_set, 0);
+  accept = final[0] - 1;
+  lazy_gcount = lazy_bcount = 0;
+
+  for(ginit_size = 0, t = transition[0]; t; t = t->nxt)
+    ginit_size++;
+  ginit = (GState **)tl_emalloc((ginit_size + 1) * sizeof(GState *));
+  for(i = 0, t = transition[0]; t; t = t->nxt)
+    ginit[i++] = find_lgstate(t->to);
+
+  binit = (BState *)tl_emalloc(sizeof(BState));
+  binit->id = -1;
+  binit->final = 0;
+  binit->gstate = (GState *)0;
+  binit->trans = (BTrans *)0;
+}
+
+static void free_ltable(LTable *t, int gba)
+{
+  LCell *c, *nxt;
+  int i;
+  for(i = 0; i < t->size; i++)
+    for(c = t->cells[i]; c; c = nxt) {
+      nxt = c->nxt;
+      if(gba) {
+        GState *s = (GState *)c->state;
+        if(s->trans) free_gtrans(s->trans->nxt, s->trans, 0);
+        tfree(s->nodes_set);
+      }
+      else {
+        BState *s = (BState *)c->state;
+        if(s->trans) free_btrans(s->trans->nxt, s->trans, 0);
+      }
+      tfree(c->state);
+      tfree(c);
+    }
+  if(t->size) tfree(t->cells);
+  t->size = t->count = 0;
+}
+
+void lazy_stop() /* frees the states explored */
+{
+  if(binit->trans) free_btrans(binit->trans->nxt, binit->trans, 0);
+  tfree(binit);
+  free_ltable(&btable, 0);
+  free_ltable(&gtable, 1);
+  tfree(ginit);
+  tfree(final);
+  free_gexp(gexp);
+}
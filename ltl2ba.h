@@ -78,13 +78,24 @@ typedef struct ATrans {
   struct ATrans *nxt;
 } ATrans;
 
-typedef struct AProd {
-  int astate;
-  struct ATrans *prod;
-  struct ATrans *trans;
-  struct AProd *nxt;
-  struct AProd *prv;
-} AProd;
+typedef struct GCand { /* transition of a state before simplification */
+  int *to;
+  int *pos;
+  int *neg;
+  int *final;
+  struct GCand *nxt;
+} GCand;
+
+typedef struct GExp { /* memory used to compute the transitions of a state */
+  int *list;            /* nodes of the state, in the order of expansion */
+  int *size;            /* number of transitions of each node */
+  struct ATrans **cur;  /* current transition of each node */
+  int **to;             /* product of the current transitions of */
+  int **pos;            /* the first i nodes, for each i */
+  int **neg;
+  struct GMemo **memo;  /* acceptance conditions of the products */
+  int memo_size, memo_count;
+} GExp;
 
 
 typedef struct GTrans {
@@ -102,6 +113,8 @@ typedef struct GState {
   struct GTrans *trans;
   struct GState *nxt;
   struct GState *prv;
+  struct PJob *job; /* expansion by another thread (option -j) */
+  int label; /* State name for printing (option -g) */
 } GState;
 
 typedef struct BTrans {
@@ -120,6 +133,7 @@ typedef struct BState {
   struct BState *nxt;
   struct BState *prv;
   int label; /* State name for printing */
+  struct PJob *job; /* solved by another thread (option -j) */
 } BState;
 
 typedef struct GScc {
@@ -200,9 +214,55 @@ void	tl_yyerror(char *);
 void	trans(Node *);
 
 void    mk_alternating(Node *);
+void    free_alternating();
 void    mk_generalized();
 void    mk_buchi();
 
+GExp   *new_gexp();
+void    free_gexp(GExp *);
+GCand  *expand_gstate(int *, GExp *);
+void    free_gcands(GCand *);
+
+void    par_start(void (*)(int, void *), void *);
+void    par_wait();
+void    par_jobs_start(void *(*)(void *, void *), void *(*)(),
+                       void (*)(void *), void (*)(void *));
+struct PJob *par_job_push(void *);
+void   *par_job_pop(struct PJob *, void *);
+void    par_job_drop(struct PJob *);
+void    par_jobs_stop();
+void    par_for(int, void (*)(int, void *), void *);
+
+void    lazy_start();
+void    lazy_stop();
+GState **lazy_ginit(int *);
+GTrans *lazy_gsucc(GState *);
+BState *lazy_binit();
+BTrans *lazy_bsucc(BState *);
+int     lazy_baccept(BState *);
+void    check_generalized();
+void    check_kripke();
+void    check_traces();
+void    check_pairs();
+void    trace_start();
+void    trace_stop();
+int     lasso_accepted(int *, int, int *, int);
+
+void    guard_start();
+void    guard_stop();
+int     guard_cube(int *, int *);
+int     guard_or(int, int);
+void    guard_print_spin(int);
+
+void    out_flush();
+void    out_write(const char *, int);
+void    out_puts(const char *);
+void    out_putc(int);
+void    out_putint(int);
+void    out_putuint(unsigned int);
+void    out_capture();
+char   *out_release(int *);
+
 ATrans *dup_trans(ATrans *);
 ATrans *merge_trans(ATrans *, ATrans *);
 void do_merge_trans(ATrans **, ATrans *, ATrans *);
@@ -250,4 +310,4 @@ typedef Node	*Nodeptr;
 #define max(x,y)        ((x>y)?x:y)
 
 /* Type for output type option */
-typedef enum output_type {OT_SPIN, OT_C, OT_JSON} output_type;
+typedef enum output_type {OT_SPIN, OT_C, OT_JSON, OT_HOA, OT_BIN, OT_CMON, OT_CBATCH} output_type;
@@ -0,0 +1,60 @@
+/***** ltl2ba : ltl2ba_bin.h *****/
+
+/* Binary format of the automata printed with -t bin.
+   The file is a header followed by arrays of unsigned int (all the
+   offsets are in bytes from the beginning of the file, and multiples
+   of 4), in the byte order of the machine which wrote it. A file can
+   be mapped in memory and used as it is: the states and transitions
+   are stored as compressed sparse rows.
+     init[nb_init]               initial states
+     first[nb_states + 1]        transitions of state s:
+                                 first[s] <= t < first[s + 1]
+     accepting[nb_states]        1 if the state is accepting (Buchi)
+     dest[nb_trans]              destination of each transition
+     pos[nb_trans * sym_words]   symbols true on each transition,
+     neg[nb_trans * sym_words]   symbols false on each transition,
+                                 symbol i is the bit i % 32 of word i / 32
+     acc[nb_trans * acc_words]   acceptance conditions met by each
+                                 transition (generalized Buchi)
+     name[nb_sym + 1]            offset of the name of each symbol
+                                 in 'names', null terminated
+   The reader (bin_reader.c) does not depend on the rest of ltl2ba.
+*/
+
+#define BIN_MAGIC       0x4142544c /* "LTBA" */
+#define BIN_VERSION     1
+#define BIN_GENERALIZED 1 /* flag: the acceptance is on the transitions */
+
+typedef struct BinHeader {
+  unsigned int magic;
+  unsigned int version;
+  unsigned int flags;
+  unsigned int size;      /* size of the file */
+  unsigned int nb_states;
+  unsigned int nb_trans;
+  unsigned int nb_init;
+  unsigned int nb_sym;
+  unsigned int nb_acc;    /* number of acceptance conditions */
+  unsigned int sym_words; /* words of a set of symbols */
+  unsigned int acc_words; /* words of a set of acceptance conditions */
+  unsigned int init, first, accepting, dest, pos, neg, acc, name, names;
+} BinHeader;
+
+typedef struct BinAut { /* an automaton read by bin_load or bin_map */
+  BinHeader *header;
+  unsigned int *init;
+  unsigned int *first;
+  unsigned int *accepting;
+  unsigned int *dest;
+  unsigned int *pos;
+  unsigned int *neg;
+  unsigned int *acc;
+  unsigned int *name;
+  char *names;
+  void *map;              /* mapping of the file, if any */
+  unsigned long map_size;
+} BinAut;
+
+BinAut *bin_load(void *, unsigned long);
+BinAut *bin_map(char *);
+void    bin_free(BinAut *);
@@ -31,6 +31,8 @@
 /* Written by Gerard J. Holzmann, Bell Laboratories, U.S.A.               */
 
 #include "ltl2ba.h"
+#include <unistd.h>
+#include <sys/wait.h>
 
 FILE	*tl_out;
 
@@ -39,10 +41,22 @@ int tl_simp_log  = 1; /* logical simplification */
 int tl_simp_diff = 1; /* automata simplification */
 int tl_simp_fly  = 1; /* on the fly simplification */
 int tl_simp_scc  = 1; /* use scc simplification */
+int tl_simp_sim  = 1; /* use simulation reduction */
 int tl_fjtofj    = 1; /* 2eme fj */
 int	tl_errs      = 0;
 int	tl_verbose   = 0;
 int	tl_terse     = 0;
+int	tl_jobs      = 1; /* number of threads */
+int	tl_check     = 0; /* 1: satisfiability, 2: validity of the formula, */
+			      /* 3: the formula holds in the model tl_kripke, */
+			      /* 4: inclusions of the pairs of tl_pairs */
+char	*tl_kripke   = (char *)0;
+char	*tl_pairs    = (char *)0;
+char	**tl_traces  = (char **)0; /* files of traces to check */
+int	tl_trace_count = 0;
+int	tl_lasso     = 0; /* number of files of lasso words */
+int	tl_gba       = 0; /* output the generalized Buchi automaton */
+int	tl_json      = 0; /* 1: compact json, 2: ndjson */
 output_type tl_type = 0; /* language of the output */
 unsigned long	All_Mem = 0;
 
@@ -52,6 +66,8 @@ static char     **ltl_file = (char **)0;
 static char     **add_ltl  = (char **)0;
 static char     out1[64];
 
+extern void	(*tl_lazy)(void);
+
 static void	tl_endstats(void);
 static void	non_fatal(char *, char *);
 
@@ -111,7 +127,19 @@ tl_Getchar(void)
 void
 put_uform(void)
 {
-	fprintf(tl_out, "%s", uform);
+	out_puts(uform);
+}
+
+void
+put_uform_quoted(void) /* prints the formula as a quoted string */
+{	char *p;
+	out_putc('"');
+	for (p = uform; *p; p++)
+	{	if (*p == '"' || *p == '\\')
+			out_putc('\\');
+		out_putc(*p);
+	}
+	out_putc('"');
 }
 
 void
@@ -129,6 +157,7 @@ usage(void)
         printf("into never claim\n");
         printf(" -F file\tlike -f, but with the LTL ");
         printf("formula stored in a 1-line file\n");
+        printf("\t\t(with -t ndjson, one formula per line)\n");
         printf(" -d\t\tdisplay automata (D)escription at each step\n");
         printf(" -s\t\tcomputing time and automata sizes (S)tatistics\n");
         printf(" -l\t\tdisable (L)ogic formula simplification\n");
@@ -136,7 +165,18 @@ usage(void)
         printf(" -o\t\tdisable (O)n-the-fly simplification\n");
         printf(" -c\t\tdisable strongly (C)onnected components simplification\n");
         printf(" -a\t\tdisable trick in (A)ccepting conditions\n");
-        printf(" -t\t\t(T)ype of the output : c, spin or json. Default : spin\n");
+        printf(" -b\t\tdisable simulation reduction of the (B)uchi automaton\n");
+        printf(" -t\t\t(T)ype of the output : c, cmon, cbatch, spin,\n");
+        printf("\t\tjson, cjson, ndjson, hoa or bin. Default : spin\n");
+        printf(" -g\t\toutput the (G)eneralized Buchi automaton (json, hoa or bin)\n");
+        printf(" -j n\t\tuse n threads (J)obs to build the automata. Default : 1\n");
+        printf(" -e\t\tcheck the formula for (E)mptiness : is it satisfiable ?\n");
+        printf(" -v\t\tcheck whether the formula is (V)alid\n");
+        printf(" -k file\tcheck whether the (K)ripke structure in file satisfies the formula\n");
+        printf(" -q file\tcompare the languages of the pairs of formulas of file (e(Q)uivalence)\n");
+        printf(" -r file\tcheck the finite t(R)aces of file against the formula\n");
+        printf("\t\t(may be repeated, the files are checked on the -j threads)\n");
+        printf(" -w file\tlike -r, but with the lasso (W)ords prefix.cycle^w of file\n");
 	
         alldone(1);
 }
@@ -155,7 +195,16 @@ tl_main(int argc, char *argv[])
 					||  argv[1][i] == '\n')
 						argv[1][i] = ' ';
 				}
-				strcpy(uform, argv[1]);
+				if (strlen(argv[1]) + (tl_check >= 2 ? 3 : 0)
+				    >= sizeof(uform))
+					fatal("formula too long", (char *)0);
+				if (tl_check >= 2)
+				{	/* valid if the negation is not satisfiable */
+					strcpy(uform, "!(");
+					strcat(uform, argv[1]);
+					strcat(uform, ")");
+				} else
+					strcpy(uform, argv[1]);
 				hasuform = strlen(uform);
 				break;
 		default :	usage();
@@ -168,6 +217,60 @@ tl_main(int argc, char *argv[])
 	return tl_errs;
 }
 
+/* Translate another formula, in the same run as the previous ones */
+void
+tl_translate(char *f)
+{
+	if (strlen(f) >= sizeof(uform))
+		fatal("formula too long", (char *)0);
+	strcpy(uform, f);
+	hasuform = strlen(uform);
+	cnt = 0;
+	tl_parse();
+}
+
+/* With -t ndjson, each line of the -F file is a formula, translated in
+   a child process of its own, which prints its line of output. The
+   children run one after the other, so the lines are in the order of
+   the file. */
+static void
+ndjson_file(char *name)
+{	FILE *f;
+	char formula[4096], *p;
+	int n, status, errs = 0;
+	long pos;
+	pid_t pid;
+
+	if (!(f = fopen(name, "r")))
+	{	printf("ltl2ba: cannot open %s\n", name);
+		alldone(1);
+	}
+	while (fgets(formula, sizeof(formula), f))
+	{	n = strlen(formula);
+		while (n && (formula[n-1] == '\n' || formula[n-1] == '\r'))
+			formula[--n] = '\0';
+		for (p = formula; *p == ' ' || *p == '\t'; p++)
+			;
+		if (!*p || *p == '#')	/* blank lines and comments */
+			continue;
+		pos = ftell(f);
+		fflush(tl_out);
+		if ((pid = fork()) == -1)
+			fatal("cannot create a process", (char *)0);
+		if (pid == 0)
+		{	tl_translate(p);
+			fflush(tl_out);
+			_exit(tl_errs ? 1 : 0);
+		}
+		if (waitpid(pid, &status, 0) == -1
+		||  !WIFEXITED(status) || WEXITSTATUS(status))
+			errs++;
+		fseek(f, pos, SEEK_SET);	/* in case the child moved it */
+	}
+	fclose(f);
+	alldone(errs ? 1 : 0);
+}
+
 int
 main(int argc, char *argv[])
 {	int i;
@@ -182,16 +285,60 @@ main(int argc, char *argv[])
                           argc--; argv++; break;
                 case 'a': tl_fjtofj = 0; break;
                 case 'c': tl_simp_scc = 0; break;
+                case 'b': tl_simp_sim = 0; break;
                 case 'o': tl_simp_fly = 0; break;
                 case 'p': tl_simp_diff = 0; break;
                 case 'l': tl_simp_log = 0; break;
                 case 'd': tl_verbose = 1; break;
                 case 's': tl_stats = 1; break;
+                case 'e': tl_check = 1; tl_lazy = check_generalized; break;
+                case 'v': tl_check = 2; tl_lazy = check_generalized; break;
+                case 'g': tl_gba = 1; break;
+                case 'k':
+                    if (argc < 3)
+                        usage();
+                    tl_check = 3; tl_kripke = argv[2]; tl_lazy = check_kripke;
+                    argc--; argv++; break;
+                case 'q':
+                    if (argc < 3)
+                        usage();
+                    tl_check = 4; tl_pairs = argv[2]; tl_lazy = check_generalized;
+                    argc--; argv++; break;
+                case 'w':
+                    tl_lasso++;
+                    /* fall through */
+                case 'r':
+                    if (argc < 3)
+                        usage();
+                    if (!tl_traces)
+                        tl_traces = (char **)emalloc(argc * sizeof(char *));
+                    tl_traces[tl_trace_count++] = argv[2];
+                    argc--; argv++; break;
+                case 'j':
+                    if (argc < 3 || (tl_jobs = atoi(argv[2])) < 1)
+                        usage();
+                    argc--; argv++; break;
                 case 't':
                     if (strcmp(argv[2], "c") == 0)
                         tl_type = OT_C;
+                    else if (strcmp(argv[2], "cmon") == 0)
+                        tl_type = OT_CMON;
+                    else if (strcmp(argv[2], "cbatch") == 0)
+                        tl_type = OT_CBATCH;
                     else if (strcmp(argv[2], "json") == 0)
                         tl_type = OT_JSON;
+                    else if (strcmp(argv[2], "cjson") == 0) {
+                        tl_type = OT_JSON;
+                        tl_json = 1;
+                    }
+                    else if (strcmp(argv[2], "ndjson") == 0) {
+                        tl_type = OT_JSON;
+                        tl_json = 2;
+                    }
+                    else if (strcmp(argv[2], "hoa") == 0)
+                        tl_type = OT_HOA;
+                    else if (strcmp(argv[2], "bin") == 0)
+                        tl_type = OT_BIN;
                     else
                         tl_type = OT_SPIN;
                     argc--; argv++; break;
@@ -200,10 +347,30 @@ main(int argc, char *argv[])
                 argc--, argv++;
         }
 
+  /* The formulas of the pairs are in a file */
+	if(tl_pairs) {
+      check_pairs();
+      alldone(0);
+	}
+
   /* Show help if no ltl formula is provided */
 	if(!ltl_file && !add_ltl)
       usage();
 
+  /* The generalized automaton is only printed in json, hoa or bin */
+	if(tl_gba && tl_type != OT_JSON && tl_type != OT_HOA && tl_type != OT_BIN)
+      usage();
+
+  /* The traces are checked on the Buchi automaton */
+	if(tl_trace_count && (tl_gba || tl_check))
+      usage();
+	if(tl_lasso && tl_lasso != tl_trace_count) /* -r and -w are not mixed */
+      usage();
+
+  /* The ndjson output has one line per formula of the file */
+	if(ltl_file && tl_type == OT_JSON && tl_json == 2)
+      ndjson_file(*ltl_file);
+
   /* If a ltl formula is provided in a file, read it and put it
    in the ltl_file variable (instead of the filename) */
         if (ltl_file)
@@ -0,0 +1,100 @@
+/***** ltl2ba : out.c *****/
+
+/* This file contains the output buffer shared by the printers of the
+   automata. The text is gathered in a buffer which is written on tl_out
+   with a single fwrite when it is full, or when out_flush is called.
+   Each printer calls out_flush when it is done, so that its output
+   stays in order with the messages printed by fprintf on tl_out.
+   After out_capture, the text is kept in memory instead, until
+   out_release gives it back.
+*/
+
+#include "ltl2ba.h"
+
+extern FILE *tl_out;
+
+#define OUT_SIZE 65536
+
+static char *out_buf = (char *)0;
+static int out_len = 0, out_size = 0;
+static int out_mem = 0; /* 1 if the output is captured in memory */
+
+static void out_grow(int n) /* makes room for n more characters */
+{
+  char *buf;
+  if(!out_mem) {
+    out_flush();
+    if(out_size >= n) return;
+  }
+  out_size = 2 * (out_size > n ? out_size : n);
+  if(out_size < OUT_SIZE) out_size = OUT_SIZE;
+  buf = emalloc(out_size);
+  if(out_len) memcpy(buf, out_buf, out_len);
+  if(out_buf) free(out_buf);
+  out_buf = buf;
+}
+
+void out_flush() /* writes the buffer on tl_out */
+{
+  if(out_mem || !out_len) return;
+  fwrite(out_buf, 1, out_len, tl_out);
+  out_len = 0;
+}
+
+void out_write(const char *s, int n) /* appends n characters */
+{
+  if(out_len + n > out_size) out_grow(n);
+  memcpy(out_buf + out_len, s, n);
+  out_len += n;
+}
+
+void out_puts(const char *s) /* appends a string */
+{
+  out_write(s, strlen(s));
+}
+
+void out_putc(int c) /* appends a character */
+{
+  if(out_len == out_size) out_grow(1);
+  out_buf[out_len++] = c;
+}
+
+void out_putuint(unsigned int u) /* appends an unsigned integer in decimal */
+{
+  char digits[16];
+  int i = 16;
+  if(out_len + 12 > out_size) out_grow(12);
+  do {
+    digits[--i] = '0' + u % 10;
+    u /= 10;
+  } while(u);
+  memcpy(out_buf + out_len, digits + i, 16 - i);
+  out_len += 16 - i;
+}
+
+void out_putint(int n) /* appends an integer in decimal */
+{
+  if(n < 0) {
+    out_putc('-');
+    out_putuint(-(unsigned int)n);
+  }
+  else out_putuint(n);
+}
+
+void out_capture() /* keeps the output in memory from now on */
+{
+  out_flush();
+  out_mem = 1;
+}
+
+char *out_release(int *len)
+{ /* stops the capture, and returns the text captured since out_capture,
+     null terminated, to be freed by free() */
+  char *s;
+  out_putc(0);
+  s = out_buf;
+  if(len) *len = out_len - 1;
+  out_buf = (char *)0;
+  out_len = out_size = out_mem = 0;
+  return s;
+}
@@ -0,0 +1,245 @@
+/***** ltl2ba : parallel.c *****/
+
+/* This file contains the functions used to run parts of the
+   translation on several threads (option -j).
+   The threads are started by par_start and run the same function,
+   each one with its own id between 1 and tl_jobs - 1 (the calling
+   thread has the id 0). They are joined by par_wait.
+   The functions run on the threads must not use tl_emalloc/tfree
+   nor the transition pools of mem.c, which are not thread safe.
+   With tl_jobs == 1, par_start starts no thread, and the jobs below are
+   all done by the main thread when it needs their results.
+*/
+
+#include "ltl2ba.h"
+#include <pthread.h>
+
+extern int tl_jobs;
+
+typedef struct PThread {
+  pthread_t thread;
+  int id;
+  void (*f)(int, void *);
+  void *arg;
+} PThread;
+
+static PThread *threads = (PThread *)0;
+static int nthreads = 0;
+
+static void *run_thread(void *p)
+{
+  PThread *t = (PThread *)p;
+  t->f(t->id, t->arg);
+  return (void *)0;
+}
+
+/* Starts tl_jobs - 1 threads running f(id, arg) */
+void par_start(void (*f)(int, void *), void *arg)
+{
+  int i;
+  if(threads)
+    fatal("par_start: threads are already running", (char *)0);
+  nthreads = tl_jobs - 1;
+  if(nthreads < 1) return;
+  threads = (PThread *)emalloc(nthreads * sizeof(PThread));
+  for(i = 0; i < nthreads; i++) {
+    threads[i].id = i + 1;
+    threads[i].f = f;
+    threads[i].arg = arg;
+    if(pthread_create(&threads[i].thread, 0, run_thread, &threads[i]))
+      fatal("par_start: cannot create a thread", (char *)0);
+  }
+}
+
+/* Waits for the threads started by par_start */
+void par_wait()
+{
+  int i;
+  for(i = 0; i < nthreads; i++)
+    pthread_join(threads[i].thread, 0);
+  if(threads) free(threads);
+  threads = (PThread *)0;
+  nthreads = 0;
+}
+
+/* Jobs computed in advance by the threads.
+   The main thread pushes a job for each piece of work it will need
+   later, the threads take the oldest waiting jobs, and the main thread
+   gets the result of a job with par_job_pop, doing the job itself if no
+   thread took it yet. Only one list of jobs exists at a time, between
+   par_jobs_start and par_jobs_stop. */
+
+#define JOB_WAITING 0
+#define JOB_RUNNING 1
+#define JOB_DONE    2
+
+typedef struct PJob {
+  void *data;     /* given to the job function, freed with the job */
+  void *result;
+  int status;
+  int dropped;    /* the result is not needed anymore */
+  struct PJob *nxt;
+  struct PJob *prv;
+} PJob;
+
+static PJob jobs; /* sentinel of the list of waiting jobs */
+static int jobs_stop;
+static void *(*job_run)(void *, void *);
+static void *(*job_new_mem)();
+static void (*job_free_mem)(void *);
+static void (*job_free_result)(void *);
+static pthread_mutex_t job_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_todo = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t job_done = PTHREAD_COND_INITIALIZER;
+
+static void job_worker(int id, void *arg) /* does jobs until stopped */
+{
+  void *mem = job_new_mem ? job_new_mem() : (void *)0;
+  void *result;
+  PJob *j;
+  pthread_mutex_lock(&job_lock);
+  while(1) {
+    while(jobs.prv == &jobs && !jobs_stop)
+      pthread_cond_wait(&job_todo, &job_lock);
+    if(jobs.prv == &jobs)
+      break;
+    j = jobs.prv; /* takes the oldest job */
+    j->prv->nxt = j->nxt;
+    j->nxt->prv = j->prv;
+    j->status = JOB_RUNNING;
+    pthread_mutex_unlock(&job_lock);
+    result = job_run(j->data, mem);
+    pthread_mutex_lock(&job_lock);
+    if(j->dropped) {
+      job_free_result(result);
+      free(j->data);
+      free(j);
+    }
+    else {
+      j->result = result;
+      j->status = JOB_DONE;
+      pthread_cond_broadcast(&job_done);
+    }
+  }
+  pthread_mutex_unlock(&job_lock);
+  if(mem) job_free_mem(mem);
+}
+
+/* Starts the threads: a job computes run(data, mem), where mem is
+   allocated by new_mem for each thread (new_mem may be 0) */
+void par_jobs_start(void *(*run)(void *, void *), void *(*new_mem)(),
+                    void (*free_mem)(void *), void (*free_result)(void *))
+{
+  job_run = run;
+  job_new_mem = new_mem;
+  job_free_mem = free_mem;
+  job_free_result = free_result;
+  jobs.nxt = jobs.prv = &jobs;
+  jobs_stop = 0;
+  par_start(job_worker, (void *)0);
+}
+
+PJob *par_job_push(void *data) /* creates a job, data is allocated by malloc */
+{
+  PJob *j = (PJob *)emalloc(sizeof(PJob));
+  j->data = data;
+  j->status = JOB_WAITING;
+  j->dropped = 0;
+  pthread_mutex_lock(&job_lock);
+  j->nxt = jobs.nxt;
+  j->prv = &jobs;
+  j->nxt->prv = j;
+  jobs.nxt = j;
+  pthread_cond_signal(&job_todo);
+  pthread_mutex_unlock(&job_lock);
+  return j;
+}
+
+void *par_job_pop(PJob *j, void *mem) /* gets the result of a job and frees it */
+{
+  void *result;
+  pthread_mutex_lock(&job_lock);
+  if(j->status == JOB_WAITING) { /* no thread took the job */
+    j->prv->nxt = j->nxt;
+    j->nxt->prv = j->prv;
+    pthread_mutex_unlock(&job_lock);
+    result = job_run(j->data, mem);
+  }
+  else {
+    while(j->status != JOB_DONE)
+      pthread_cond_wait(&job_done, &job_lock);
+    pthread_mutex_unlock(&job_lock);
+    result = j->result;
+  }
+  free(j->data);
+  free(j);
+  return result;
+}
+
+void par_job_drop(PJob *j) /* frees a job whose result is not needed */
+{
+  pthread_mutex_lock(&job_lock);
+  if(j->status == JOB_RUNNING)
+    j->dropped = 1; /* the thread will free the job */
+  else {
+    if(j->status == JOB_WAITING) {
+      j->prv->nxt = j->nxt;
+      j->nxt->prv = j->prv;
+    }
+    else
+      job_free_result(j->result);
+    free(j->data);
+    free(j);
+  }
+  pthread_mutex_unlock(&job_lock);
+}
+
+void par_jobs_stop() /* stops the threads once the waiting jobs are done */
+{
+  pthread_mutex_lock(&job_lock);
+  jobs_stop = 1;
+  pthread_cond_broadcast(&job_todo);
+  pthread_mutex_unlock(&job_lock);
+  par_wait();
+}
+
+/* Loop whose iterations are independent: par_for calls f(i, arg) for
+   each i between 0 and n - 1, on tl_jobs threads. The iterations are
+   taken by small blocks, in any order. */
+
+#define FOR_BLOCK 16
+
+static int for_next, for_n;
+static void (*for_f)(int, void *);
+static pthread_mutex_t for_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void for_worker(int id, void *arg)
+{
+  int i, end;
+  while(1) {
+    pthread_mutex_lock(&for_lock);
+    i = for_next;
+    for_next += FOR_BLOCK;
+    pthread_mutex_unlock(&for_lock);
+    if(i >= for_n) return;
+    end = (i + FOR_BLOCK < for_n) ? i + FOR_BLOCK : for_n;
+    for(; i < end; i++)
+      for_f(i, arg);
+  }
+}
+
+void par_for(int n, void (*f)(int, void *), void *arg)
+{
+  int i;
+  if(tl_jobs == 1 || n <= FOR_BLOCK) { /* not worth starting threads */
+    for(i = 0; i < n; i++)
+      f(i, arg);
+    return;
+  }
+  for_next = 0;
+  for_n = n;
+  for_f = f;
+  par_start(for_worker, arg);
+  for_worker(0, arg);
+  par_wait();
+}
@@ -567,6 +567,7 @@ tl_parse(void)
         if (tl_verbose)
 	{	printf("formula: ");
 		put_uform();
+		out_flush();
 		printf("\n");
 	}
 	trans(n);
@@ -124,41 +124,42 @@ void spin_print_set(int *pos, int *neg) /* prints the content of a set for spin
     for(j = 0; j < mod; j++) {
       if(pos[i] & (1 << j)) {
 	if(!start)
-	  fprintf(tl_out, " && ");
-	fprintf(tl_out, "%s", sym_table[mod * i + j]);
+	  out_puts(" && ");
+	out_puts(sym_table[mod * i + j]);
 	start = 0;
       }
       if(neg[i] & (1 << j)) {
 	if(!start)
-	  fprintf(tl_out, " && ");
-	fprintf(tl_out, "!%s", sym_table[mod * i + j]);
+	  out_puts(" && ");
+	out_putc('!');
+	out_puts(sym_table[mod * i + j]);
 	start = 0;
       }
     }
   if(start)
-    fprintf(tl_out, "1");
+    out_putc('1');
 }
 
 void print_set(int *l, int type) /* prints the content of a set */
 {
   int i, j, start = 1;;
-  if(type != 1) fprintf(tl_out, "{");
+  if(type != 1) out_putc('{');
   for(i = 0; i < set_size(type); i++) 
     for(j = 0; j < mod; j++)
       if(l[i] & (1 << j)) {
         switch(type) {
           case 0: case 2:
-            if(!start) fprintf(tl_out, ",");
-            fprintf(tl_out, "%i", mod * i + j);
+            if(!start) out_putc(',');
+            out_putint(mod * i + j);
             break;
           case 1:
-            if(!start) fprintf(tl_out, " & ");
-            fprintf(tl_out, "%s", sym_table[mod * i + j]);
+            if(!start) out_puts(" & ");
+            out_puts(sym_table[mod * i + j]);
             break;
         }
         start = 0;
       }
-  if(type != 1) fprintf(tl_out, "}");
+  if(type != 1) out_putc('}');
 }
 
 int empty_set(int *l, int type) /* tests if a set is the empty set */
@@ -0,0 +1,613 @@
+/***** ltl2ba : trace.c *****/
+
+/* This file contains the check of finite traces against the formula
+   (option -r). A trace file is either a text file such as:
+
+     # comments begin with '#'
+     p q
+     -
+     p
+
+     q
+
+   where each line is a step, giving the propositions true in it, and
+   the traces are separated by blank lines ('-', like any word which is
+   not a proposition of the formula, is ignored: it makes a step where
+   no proposition holds), or a binary file made of unsigned int in the
+   byte order of the machine which wrote it:
+
+     magic                  TRACE_MAGIC
+     nb_sym                 number of propositions
+     names                  nb_sym null terminated names, padded with
+                            zeros to a multiple of 4 bytes
+     then for each trace:
+     length                 number of steps
+     steps[length * words]  the propositions true in each step, where
+                            words = (nb_sym + 31) / 32 and proposition i
+                            is the bit i % 32 of word i / 32
+
+   The files are mapped in memory, and the traces are first located in
+   them. They are then checked on tl_jobs threads: the Buchi automaton
+   reads each trace from the set of its initial states, the sets of
+   states being bitsets. As in the C printer, a trace is accepted if
+   its extension by the repetition of its last step is accepted, and the
+   check of a trace stops as soon as a surely accepting state is
+   reached, or all the reached states are surely rejecting.
+   With the option -w, the text files hold lasso words u.v^w instead:
+   a line 'cycle:' separates the steps of u from the ones of v (without
+   it, v is the last step). The states reached after u are computed as
+   above, then an accepting cycle is searched in the product of the
+   automaton with the loop v, by Tarjan's algorithm. The same check is
+   given to the rest of ltl2ba by lasso_accepted.
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "ltl2ba.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#define TRACE_MAGIC 0x5254544c /* "LTTR" */
+
+extern FILE *tl_out;
+extern struct rusage tr_debut, tr_fin;
+extern struct timeval t_diff;
+extern int tl_stats, tl_trace_count, tl_lasso, accept, sym_id, sym_size, mod, n_ba_state;
+extern char **sym_table, **tl_traces;
+extern BState *bstates;
+extern _Bool *stutter_acceptance_table, *surely_accept_table, *surely_reject_table;
+extern void alldone(int);
+
+extern void build_stutter_tables();
+extern int stutter_class(int *);
+extern void free_stutter_acceptance();
+
+typedef struct TFile { /* a file of traces, mapped in memory */
+  char *name;
+  char *map;
+  long size;
+  int binary;
+  int *bit_sym;   /* binary: the proposition of each bit of a step, or -1 */
+  int nb_sym;     /* binary: bits of a step used by the propositions */
+  int step_words; /* binary: words of a step */
+} TFile;
+
+typedef struct Trace { /* a trace located in a file */
+  int file;
+  int length; /* binary: number of steps */
+  long start; /* offset of the first step */
+  long end;   /* text: offset of the end of the last step */
+} Trace;
+
+/* verdicts */
+#define V_ACCEPT         1 /* every extension of the trace is accepted */
+#define V_REJECT         2 /* no extension of the trace is accepted */
+#define V_STUTTER_ACCEPT 3 /* the repetition of the last step is accepted */
+#define V_STUTTER_REJECT 4 /* the repetition of the last step is rejected */
+
+static char *verdict_name[] = { "", "accepted", "rejected",
+                                "stutter accepted", "stutter rejected" };
+
+static TFile *tfiles;
+static Trace *traces;
+static int trace_count, trace_max;
+static char *verdicts;
+
+/* The automaton: states are numbered by their label, their transitions
+   are stored as compressed rows, and the sets of states are bitsets */
+static int state_words;
+static int *first, *dest, *pos, *neg;
+static unsigned int *init_set, *final_set, *sure_accept, *sure_reject;
+
+/********************************************************************\
+|*              Location of the traces in the files                 *|
+\********************************************************************/
+
+static void trace_error(TFile *f, char *s)
+{
+  printf("ltl2ba: %s: %s\n", f->name, s);
+  alldone(1);
+}
+
+static void add_trace(int file, long start, long end, int length)
+{
+  Trace *t;
+  if(trace_count == trace_max) {
+    t = (Trace *)tl_emalloc(2 * (trace_max + 256) * sizeof(Trace));
+    if(trace_max) {
+      memcpy(t, traces, trace_max * sizeof(Trace));
+      tfree(traces);
+    }
+    traces = t;
+    trace_max = 2 * (trace_max + 256);
+  }
+  traces[trace_count].file = file;
+  traces[trace_count].start = start;
+  traces[trace_count].end = end;
+  traces[trace_count++].length = length;
+}
+
+static long skip_blanks(char *p, long i, long end)
+{ /* the first character from i which is not a space or a tab */
+  while(i < end && (p[i] == ' ' || p[i] == '\t' || p[i] == '\r'))
+    i++;
+  return i;
+}
+
+static void locate_text(int file)
+{ /* the traces are the blocks of lines separated by blank lines */
+  TFile *f = &tfiles[file];
+  long i = 0, line, start = -1, end = 0;
+  char *p = f->map;
+
+  while(i < f->size) {
+    line = skip_blanks(p, i, f->size);
+    for(i = line; i < f->size && p[i] != '\n'; i++)
+      ;
+    if(line == i) { /* a blank line */
+      if(start != -1) add_trace(file, start, end, 0);
+      start = -1;
+    }
+    else if(p[line] != '#') { /* a step */
+      if(start == -1) start = line;
+      end = i;
+    }
+    i++;
+  }
+  if(start != -1) add_trace(file, start, end, 0);
+}
+
+static void locate_binary(int file)
+{
+  TFile *f = &tfiles[file];
+  unsigned int *w = (unsigned int *)f->map, nb_sym;
+  unsigned long off, steps;
+  long i, j;
+  unsigned int k;
+
+  if(f->size < 8) trace_error(f, "truncated header");
+  nb_sym = w[1];
+  if(nb_sym > f->size) trace_error(f, "bad number of propositions");
+  f->nb_sym = nb_sym;
+  f->bit_sym = (int *)tl_emalloc((nb_sym + 1) * sizeof(int));
+  for(off = 8, k = 0; k < nb_sym; k++) { /* the names */
+    for(i = off; i < f->size && f->map[i]; i++)
+      ;
+    if(i == f->size) trace_error(f, "truncated names");
+    f->bit_sym[k] = -1;
+    for(j = 0; j < sym_id; j++)
+      if(!strcmp(sym_table[j], f->map + off)) f->bit_sym[k] = j;
+    off = i + 1;
+  }
+  off = (off + 3) & ~3UL;
+  f->step_words = (nb_sym + 31) / 32;
+
+  while(off < (unsigned long)f->size) { /* the traces */
+    if(f->size - off < 4) trace_error(f, "truncated trace");
+    steps = w[off / 4];
+    if((f->size - off - 4) / 4 / (f->step_words ? f->step_words : 1) < steps)
+      trace_error(f, "truncated trace");
+    if(steps > 0x7fffffff) trace_error(f, "trace too long");
+    add_trace(file, off + 4, 0, (int)steps);
+    off += 4 + 4 * steps * f->step_words;
+  }
+}
+
+static void map_file(int file)
+{
+  TFile *f = &tfiles[file];
+  struct stat st;
+  int fd;
+
+  f->name = tl_traces[file];
+  if((fd = open(f->name, O_RDONLY)) < 0 || fstat(fd, &st) < 0) {
+    printf("ltl2ba: cannot open %s\n", f->name);
+    alldone(1);
+  }
+  f->size = st.st_size;
+  f->map = (char *)0;
+  if(f->size > 0) {
+    f->map = (char *)mmap(0, f->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(f->map == (char *)MAP_FAILED) {
+      printf("ltl2ba: cannot map %s\n", f->name);
+      alldone(1);
+    }
+  }
+  close(fd);
+
+  f->binary = f->size >= 4 && *(unsigned int *)f->map == TRACE_MAGIC;
+  if(f->binary && tl_lasso) trace_error(f, "the lassos are read from text files");
+  if(f->binary) locate_binary(file);
+  else locate_text(file);
+}
+
+/********************************************************************\
+|*              Check of a trace                                    *|
+\********************************************************************/
+
+void trace_start()
+{ /* the transitions and the sets of states of the automaton */
+  BState *s;
+  BTrans *t;
+  int n = 0, i;
+
+  build_stutter_tables();
+  for(s = bstates->prv; s != bstates; s = s->prv)
+    for(t = s->trans->nxt; t != s->trans; t = t->nxt)
+      n++;
+  state_words = n_ba_state / 32 + 1;
+  first = (int *)tl_emalloc((n_ba_state + 1) * sizeof(int));
+  dest = (int *)tl_emalloc((n + 1) * sizeof(int));
+  pos = (int *)tl_emalloc((n * sym_size + 1) * sizeof(int));
+  neg = (int *)tl_emalloc((n * sym_size + 1) * sizeof(int));
+  init_set = (unsigned int *)tl_emalloc(state_words * sizeof(int));
+  final_set = (unsigned int *)tl_emalloc(state_words * sizeof(int));
+  sure_accept = (unsigned int *)tl_emalloc(state_words * sizeof(int));
+  sure_reject = (unsigned int *)tl_emalloc(state_words * sizeof(int));
+
+  n = 0;
+  for(s = bstates->prv; s != bstates; s = s->prv) { /* by label */
+    first[s->label] = n;
+    for(t = s->trans->nxt; t != s->trans; t = t->nxt, n++) {
+      dest[n] = t->to->label;
+      for(i = 0; i < sym_size; i++) {
+        pos[n * sym_size + i] = t->pos[i];
+        neg[n * sym_size + i] = t->neg[i];
+      }
+    }
+    if(s->id == -1)
+      init_set[s->label / 32] |= 1u << s->label % 32;
+    /* s->id == 0 means s is an accepting well */
+    if(s->final == accept || s->id == 0)
+      final_set[s->label / 32] |= 1u << s->label % 32;
+    if(surely_accept_table[s->label])
+      sure_accept[s->label / 32] |= 1u << s->label % 32;
+    if(surely_reject_table[s->label])
+      sure_reject[s->label / 32] |= 1u << s->label % 32;
+  }
+  first[n_ba_state] = n;
+}
+
+void trace_stop()
+{
+  tfree(first);
+  tfree(dest);
+  tfree(pos);
+  tfree(neg);
+  tfree(init_set);
+  tfree(final_set);
+  tfree(sure_accept);
+  tfree(sure_reject);
+  free_stutter_acceptance();
+}
+
+static void step(unsigned int *cur, unsigned int *nxt, int *val)
+{ /* the states reached from cur when reading val */
+  unsigned int bits;
+  int w, s, t, i, *p, *q;
+
+  for(w = 0; w < state_words; w++)
+    nxt[w] = 0;
+  for(w = 0; w < state_words; w++)
+    for(bits = cur[w], s = 32 * w; bits; bits >>= 1, s++) {
+      if(!(bits & 1)) continue;
+      for(t = first[s]; t < first[s + 1]; t++) {
+        p = pos + t * sym_size;
+        q = neg + t * sym_size;
+        for(i = 0; i < sym_size; i++)
+          if((p[i] & ~val[i]) | (q[i] & val[i]))
+            break;
+        if(i == sym_size)
+          nxt[dest[t] / 32] |= 1u << dest[t] % 32;
+      }
+    }
+}
+
+static int sure_verdict(unsigned int *cur)
+{ /* V_ACCEPT, V_REJECT, or 0 if the suffix of the trace matters */
+  int w, reject = 1;
+  for(w = 0; w < state_words; w++) {
+    if(cur[w] & sure_accept[w]) return V_ACCEPT;
+    if(cur[w] & ~sure_reject[w]) reject = 0;
+  }
+  return reject ? V_REJECT : 0;
+}
+
+static char *text_step(char *p, char *end, int *val, int *is_step)
+{ /* reads the line at p into val; returns the beginning of the next line.
+     is_step is 0 for a comment, 2 for the line 'cycle:' of a lasso; val
+     is only written for a step, so it keeps the last step otherwise */
+  char *w;
+  int i, n;
+  *is_step = 0;
+  while(p < end && *p != '\n' && *p != '#') {
+    if(*p == ' ' || *p == '\t' || *p == '\r' || *p == ',') {
+      p++;
+      continue;
+    }
+    for(w = p; p < end && !strchr(" \t\r\n,#", *p); p++)
+      ;
+    n = p - w;
+    if(n == 6 && !strncmp(w, "cycle:", 6)) {
+      *is_step = 2;
+      continue;
+    }
+    if(*is_step != 1) { /* the first word of a step */
+      *is_step = 1;
+      for(i = 0; i < sym_size; i++)
+        val[i] = 0;
+    }
+    for(i = 0; i < sym_id; i++)
+      if(!strncmp(sym_table[i], w, n) && !sym_table[i][n]) {
+        val[i / mod] |= 1 << i % mod;
+        break;
+      }
+  }
+  while(p < end && *p != '\n')
+    p++;
+  return p + 1;
+}
+
+static void binary_step(TFile *f, unsigned int *s, int *val)
+{
+  unsigned int bits;
+  int w, b, i;
+  for(i = 0; i < sym_size; i++)
+    val[i] = 0;
+  for(w = 0; w < f->step_words; w++)
+    for(bits = s[w], b = 32 * w; bits && b < f->nb_sym; bits >>= 1, b++)
+      if((bits & 1) && (i = f->bit_sym[b]) != -1)
+        val[i / mod] |= 1 << i % mod;
+}
+
+static int run_trace(Trace *tr, unsigned int *cur, unsigned int *nxt, int *val)
+{
+  TFile *f = &tfiles[tr->file];
+  unsigned int *swap, *s;
+  char *p, *end;
+  int i, v, is_step;
+
+  memcpy(cur, init_set, state_words * sizeof(int));
+  for(i = 0; i < sym_size; i++)
+    val[i] = 0;
+  if((v = sure_verdict(cur)))
+    return v;
+
+  if(f->binary) {
+    s = (unsigned int *)(f->map + tr->start);
+    for(i = 0; i < tr->length; i++, s += f->step_words) {
+      binary_step(f, s, val);
+      step(cur, nxt, val);
+      swap = cur; cur = nxt; nxt = swap;
+      if((v = sure_verdict(cur)))
+        return v;
+    }
+  }
+  else
+    for(p = f->map + tr->start, end = f->map + tr->end; p < end; ) {
+      p = text_step(p, end, val, &is_step);
+      if(is_step != 1) continue; /* a comment */
+      step(cur, nxt, val);
+      swap = cur; cur = nxt; nxt = swap;
+      if((v = sure_verdict(cur)))
+        return v;
+    }
+
+  /* the last step is repeated forever */
+  v = stutter_class(val) * n_ba_state;
+  for(i = 0; i < n_ba_state; i++)
+    if((cur[i / 32] >> i % 32 & 1) && stutter_acceptance_table[v + i])
+      return V_STUTTER_ACCEPT;
+  return V_STUTTER_REJECT;
+}
+
+/********************************************************************\
+|*              Check of a lasso                                    *|
+\********************************************************************/
+
+static int guard_holds(int t, int *val)
+{
+  int i, *p = pos + t * sym_size, *q = neg + t * sym_size;
+  for(i = 0; i < sym_size; i++)
+    if((p[i] & ~val[i]) | (q[i] & val[i]))
+      return 0;
+  return 1;
+}
+
+static int accepting_cycle(unsigned int *cur, int *loop, int m)
+{ /* is there an accepting cycle reachable from the states cur in the
+     product with the loop ? The state (s, i) of the product is the
+     state s of the automaton before the step i of the loop, numbered
+     i * n_ba_state + s. Iterative Tarjan's algorithm, the components
+     being completed successors first. */
+  int n = n_ba_state * m, root, x, d, t, k, i, top = 0, depth, num = 0;
+  int *index = (int *)emalloc(6 * (n + 1) * sizeof(int));
+  int *low = index + n + 1;
+  int *comp = low + n + 1;
+  int *stack = comp + n + 1;
+  int *call = stack + n + 1;
+  int *next_trans = call + n + 1;
+  int base, cycle, final, found = 0;
+
+  for(x = 0; x < n; x++)
+    index[x] = comp[x] = -1;
+  for(root = 0; root < n_ba_state && !found; root++) {
+    if(!(cur[root / 32] >> root % 32 & 1) || index[root] != -1)
+      continue;
+    index[root] = low[root] = num++;
+    next_trans[root] = first[root];
+    stack[top++] = root;
+    depth = 0;
+    call[depth++] = root;
+
+    while(depth && !found) {
+      x = call[depth - 1];
+      k = x / n_ba_state;
+      for(t = next_trans[x]; t < first[x % n_ba_state + 1]; t++)
+        if(guard_holds(t, loop + k * sym_size))
+          break;
+      if(t < first[x % n_ba_state + 1]) { /* follows the transition t */
+        next_trans[x] = t + 1;
+        d = (k + 1) % m * n_ba_state + dest[t];
+        if(index[d] == -1) {
+          index[d] = low[d] = num++;
+          next_trans[d] = first[dest[t]];
+          stack[top++] = d;
+          call[depth++] = d;
+        }
+        else if(comp[d] == -1 && index[d] < low[x]) /* d is on the stack */
+          low[x] = index[d];
+        continue;
+      }
+
+      depth--; /* all the successors of x are visited */
+      if(depth && low[x] < low[call[depth - 1]])
+        low[call[depth - 1]] = low[x];
+      if(low[x] != index[x])
+        continue;
+
+      /* x is the root of a component: the states above it on the stack */
+      for(base = top - 1; stack[base] != x; base--)
+        comp[stack[base]] = x;
+      comp[x] = x;
+      cycle = final = 0;
+      for(i = base; i < top; i++) {
+        d = stack[i];
+        k = d / n_ba_state;
+        if(final_set[d % n_ba_state / 32] >> d % n_ba_state % 32 & 1)
+          final = 1;
+        for(t = first[d % n_ba_state]; t < first[d % n_ba_state + 1]; t++)
+          if(comp[(k + 1) % m * n_ba_state + dest[t]] == x &&
+             guard_holds(t, loop + k * sym_size))
+            cycle = 1;
+      }
+      found = cycle && final;
+      top = base;
+    }
+  }
+  free(index);
+  return found;
+}
+
+/* Return 1 if the automaton accepts the lasso word prefix.loop^w, where
+   prefix and loop are n and m > 0 valuations of sym_size words. It must
+   be called between trace_start and trace_stop, and may run on the
+   threads of par_for. */
+int lasso_accepted(int *prefix, int n, int *loop, int m)
+{
+  unsigned int *mem = (unsigned int *)emalloc(2 * state_words * sizeof(int));
+  unsigned int *cur = mem, *nxt = mem + state_words, *swap;
+  int i, v = 0;
+
+  memcpy(cur, init_set, state_words * sizeof(int));
+  for(i = 0; i < n && !(v = sure_verdict(cur)); i++) {
+    step(cur, nxt, prefix + i * sym_size);
+    swap = cur; cur = nxt; nxt = swap;
+  }
+  if(!v)
+    v = sure_verdict(cur);
+  if(!v)
+    v = accepting_cycle(cur, loop, m) ? V_ACCEPT : V_REJECT;
+  free(mem);
+  return v == V_ACCEPT;
+}
+
+static int run_lasso(Trace *tr)
+{
+  TFile *f = &tfiles[tr->file];
+  char *p, *end = f->map + tr->end;
+  int *val, n = 0, loop = -1, is_step, v;
+
+  for(p = f->map + tr->start; p < end; n++) /* lines, more than the steps */
+    while(p < end && *p++ != '\n')
+      ;
+  val = (int *)emalloc((n + 1) * sym_size * sizeof(int));
+  for(p = f->map + tr->start, n = 0; p < end; ) {
+    p = text_step(p, end, val + n * sym_size, &is_step);
+    if(is_step == 2) loop = n;
+    if(is_step == 1) n++;
+  }
+  if(loop == -1 || loop == n) { /* the loop is the last step */
+    if(!n) n++; /* a step where no proposition holds */
+    loop = n - 1;
+  }
+  v = lasso_accepted(val, loop, val + loop * sym_size, n - loop) ?
+    V_ACCEPT : V_REJECT;
+  free(val);
+  return v;
+}
+
+/* Check the trace i. It runs on the threads of par_for : the sets of
+   states are on the stack, or allocated with emalloc when too large */
+static void check_trace(int i, void *arg)
+{
+  unsigned int small[256], *mem = small;
+  int n = 2 * state_words + sym_size;
+
+  if(n > 256)
+    mem = (unsigned int *)emalloc(n * sizeof(int));
+  if(tl_lasso)
+    verdicts[i] = run_lasso(&traces[i]);
+  else
+    verdicts[i] = run_trace(&traces[i], mem, mem + state_words,
+                            (int *)(mem + 2 * state_words));
+  if(mem != small)
+    free(mem);
+}
+
+/********************************************************************\
+|*              Main function of the check                          *|
+\********************************************************************/
+
+void check_traces()
+{ /* checks the traces of the files tl_traces against the formula */
+  int i, k, count[V_STUTTER_REJECT + 1];
+
+  if(tl_stats) getrusage(RUSAGE_SELF, &tr_debut);
+
+  trace_start();
+  tfiles = (TFile *)tl_emalloc(tl_trace_count * sizeof(TFile));
+  trace_count = trace_max = 0;
+  for(i = 0; i < tl_trace_count; i++)
+    map_file(i);
+
+  verdicts = (char *)tl_emalloc(trace_count + 1);
+  par_for(trace_count, check_trace, (void *)0);
+
+  for(i = 0; i <= V_STUTTER_REJECT; i++)
+    count[i] = 0;
+  for(i = 0, k = 0; i < trace_count; i++) {
+    k = (i && traces[i].file == traces[i - 1].file) ? k + 1 : 1;
+    out_puts(tfiles[traces[i].file].name);
+    out_putc(':');
+    out_putint(k);
+    out_puts(": ");
+    out_puts(verdict_name[(int)verdicts[i]]);
+    out_putc('\n');
+    count[(int)verdicts[i]]++;
+  }
+  out_flush();
+
+  if(tl_stats) {
+    getrusage(RUSAGE_SELF, &tr_fin);
+    timeval_subtract (&t_diff, &tr_fin.ru_utime, &tr_debut.ru_utime);
+    fprintf(tl_out, "\nCheck of the traces : %i.%06is",
+		t_diff.tv_sec, t_diff.tv_usec);
+    fprintf(tl_out, "\n%i traces: %i accepted, %i rejected, "
+            "%i stutter accepted, %i stutter rejected\n", trace_count,
+            count[V_ACCEPT], count[V_REJECT],
+            count[V_STUTTER_ACCEPT], count[V_STUTTER_REJECT]);
+  }
+
+  for(i = 0; i < tl_trace_count; i++) {
+    if(tfiles[i].map) munmap(tfiles[i].map, tfiles[i].size);
+    if(tfiles[i].binary) tfree(tfiles[i].bit_sym);
+  }
+  tfree(tfiles);
+  if(trace_max) tfree(traces);
+  tfree(verdicts);
+  trace_stop();
+}
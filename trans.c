@@ -33,6 +33,8 @@
 #include "ltl2ba.h"
 
 extern int tl_verbose, tl_terse, tl_errs;
+extern void (*tl_lazy)(void);
+extern int tl_gba;
 extern FILE	*tl_out;
 
 int	Stack_mx=0, Max_Red=0, Total=0;
@@ -169,7 +171,15 @@ void trans(Node *p)
     return;
 
   mk_alternating(p);
+  if (tl_lazy) { /* the automata are explored on demand by tl_lazy */
+    lazy_start();
+    tl_lazy();
+    lazy_stop();
+    free_alternating();
+    return;
+  }
   mk_generalized();
-  mk_buchi();
+  if (!tl_gba) /* otherwise the generalized automaton is the output */
+    mk_buchi();
 }
 